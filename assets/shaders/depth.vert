@@ -0,0 +1,23 @@
+#version 450
+
+// position-only stream, quantized positions are undone by the model matrix like in the color pass
+layout (location = 0) in vec3 vPosition;
+
+layout(set = 0, binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewproj;
+} cameraData;
+
+layout(push_constant) uniform constants {
+    mat4 model;
+} inConstants;
+
+// the color pass computes the same expression, invariant keeps both depths bit exact
+invariant gl_Position;
+
+void main()
+{
+    mat4 transformMatrix = (cameraData.viewproj * inConstants.model);
+    gl_Position = transformMatrix * vec4(vPosition, 1.0f);
+}
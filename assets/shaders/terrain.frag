@@ -0,0 +1,21 @@
+#version 450
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in float inHeight;
+
+layout (location = 0) out vec4 outFragColor;
+
+const vec3 sunDirection = normalize(vec3(0.4f, 1.0f, 0.3f));
+
+void main()
+{
+    vec3 normal = normalize(inNormal);
+    // grass in the valleys, rock on steep slopes and snow on the peaks
+    vec3 grass = vec3(0.22f, 0.36f, 0.14f);
+    vec3 rock = vec3(0.38f, 0.34f, 0.3f);
+    vec3 snow = vec3(0.9f, 0.92f, 0.95f);
+    vec3 color = mix(grass, rock, smoothstep(0.75f, 0.55f, normal.y));
+    color = mix(color, snow, smoothstep(0.7f, 0.8f, inHeight) * smoothstep(0.5f, 0.7f, normal.y));
+    float light = max(dot(normal, sunDirection), 0.0f) * 0.85f + 0.15f;
+    outFragColor = vec4(color * light, 1.0f);
+}
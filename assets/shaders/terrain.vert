@@ -0,0 +1,15 @@
+#version 450
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vColor;
+layout (location = 3) in vec2 vTexCoord;
+
+layout (location = 0) out vec2 outTexCoord;
+
+// patch corners are passed on as they are, the evaluation stage places the generated vertices
+void main()
+{
+    gl_Position = vec4(vPosition, 1.0f);
+    outTexCoord = vTexCoord;
+}
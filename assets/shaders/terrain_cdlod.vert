@@ -0,0 +1,68 @@
+#version 450
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vColor;
+layout (location = 3) in vec2 vTexCoord;
+// world xz of the node corner, its edge length and lod
+layout (location = 4) in vec4 inNode;
+// distances where the morph into the next coarser lod starts and ends
+layout (location = 5) in vec4 inMorph;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out float outHeight;
+
+layout(set = 0, binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewproj;
+} cameraData;
+
+layout(set = 1, binding = 2) uniform sampler2D heightmap;
+
+layout(push_constant) uniform constants {
+    vec4 cameraPosition;
+    // xyz origin of the terrain, w its edge length
+    vec4 terrain;
+    float heightScale;
+    float gridSize;
+} inConstants;
+
+// height back to [0, 1] and the normal bytes to [-1, 1]
+vec3 decodeTexel(vec4 texel)
+{
+    return vec3((texel.r * 65280.0f + texel.g * 255.0f) / 65535.0f, texel.ba * 2.0f - 1.0f);
+}
+
+// the packed bytes can't be filtered by the sampler, the four texels around the position are decoded and mixed here
+vec3 sampleTerrain(vec2 world)
+{
+    vec2 uv = (world - inConstants.terrain.xz) / inConstants.terrain.w;
+    ivec2 size = textureSize(heightmap, 0);
+    vec2 position = clamp(uv, 0.0f, 1.0f) * vec2(size - 1);
+    ivec2 texel = min(ivec2(position), size - 2);
+    vec2 weight = position - vec2(texel);
+    vec3 top = mix(decodeTexel(texelFetch(heightmap, texel, 0)), decodeTexel(texelFetch(heightmap, texel + ivec2(1, 0), 0)), weight.x);
+    vec3 bottom = mix(decodeTexel(texelFetch(heightmap, texel + ivec2(0, 1), 0)), decodeTexel(texelFetch(heightmap, texel + ivec2(1, 1), 0)), weight.x);
+    return mix(top, bottom, weight.y);
+}
+
+void main()
+{
+    vec2 gridPosition = vPosition.xz;
+    vec2 world = inNode.xy + gridPosition * inNode.z;
+    float height = sampleTerrain(world).x * inConstants.heightScale + inConstants.terrain.y;
+    float viewDistance = distance(vec3(world.x, height, world.y), inConstants.cameraPosition.xyz);
+    float morph = clamp((viewDistance - inMorph.x) / (inMorph.y - inMorph.x), 0.0f, 1.0f);
+    // odd vertices slide onto their even neighbours, fully morphed the node matches the grid of the next coarser lod
+    // and meets the nodes of that lod without cracks
+    vec2 odd = fract(gridPosition * inConstants.gridSize * 0.5f) * 2.0f / inConstants.gridSize;
+    gridPosition -= odd * morph;
+
+    world = inNode.xy + gridPosition * inNode.z;
+    vec3 terrain = sampleTerrain(world);
+    vec2 normalXZ = terrain.yz;
+    gl_Position = cameraData.viewproj * vec4(world.x, terrain.x * inConstants.heightScale + inConstants.terrain.y, world.y, 1.0f);
+    outNormal = vec3(normalXZ.x, sqrt(max(1.0f - dot(normalXZ, normalXZ), 0.0f)), normalXZ.y);
+    outHeight = terrain.x;
+}
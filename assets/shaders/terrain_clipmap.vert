@@ -0,0 +1,61 @@
+#version 450
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vColor;
+layout (location = 3) in vec2 vTexCoord;
+// world xz of the block, texel spacing and level
+layout (location = 4) in vec4 inBlock;
+// xz center of the level, where its transition into the next coarser level starts and how wide it is
+layout (location = 5) in vec4 inTransition;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out float outHeight;
+
+layout(set = 0, binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewproj;
+} cameraData;
+
+// one layer per level, texel (x, y) of a level is stored at (x, y) mod the layer size
+layout(set = 1, binding = 2) uniform sampler2DArray heightLevels;
+
+layout(push_constant) uniform constants {
+    float heightScale;
+    float baseHeight;
+    float levelCount;
+} inConstants;
+
+// height back to [0, 1] and the normal bytes to [-1, 1]
+vec3 fetchLevel(ivec2 texel, int level)
+{
+    ivec2 size = textureSize(heightLevels, 0).xy;
+    vec4 bytes = texelFetch(heightLevels, ivec3(texel & (size - 1), level), 0);
+    return vec3((bytes.r * 65280.0f + bytes.g * 255.0f) / 65535.0f, bytes.ba * 2.0f - 1.0f);
+}
+
+void main()
+{
+    int level = int(inBlock.w);
+    vec2 world = inBlock.xy + vPosition.xz * inBlock.z;
+    ivec2 texel = ivec2(round(world / inBlock.z));
+    vec3 terrain = fetchLevel(texel, level);
+
+    // near the edge of the level its vertices move onto the surface of the coarser level, which meets it there
+    vec2 centerDistance = abs(world - inTransition.xy);
+    float blend = clamp((max(centerDistance.x, centerDistance.y) - inTransition.z) / inTransition.w, 0.0f, 1.0f);
+    if (blend > 0.0f && level + 1 < int(inConstants.levelCount)) {
+        // odd texels sit between two texels of the coarser level
+        ivec2 coarse = texel >> 1;
+        ivec2 odd = texel & 1;
+        vec3 coarseTerrain = (fetchLevel(coarse, level + 1) + fetchLevel(coarse + ivec2(odd.x, 0), level + 1) +
+                              fetchLevel(coarse + ivec2(0, odd.y), level + 1) + fetchLevel(coarse + odd, level + 1)) * 0.25f;
+        terrain = mix(terrain, coarseTerrain, blend);
+    }
+
+    vec2 normalXZ = terrain.yz;
+    gl_Position = cameraData.viewproj * vec4(world.x, terrain.x * inConstants.heightScale + inConstants.baseHeight, world.y, 1.0f);
+    outNormal = vec3(normalXZ.x, sqrt(max(1.0f - dot(normalXZ, normalXZ), 0.0f)), normalXZ.y);
+    outHeight = terrain.x;
+}
@@ -18,6 +18,9 @@ layout(push_constant) uniform constants {
     mat4 model;
 } inConstants;
 
+// matches the depth prepass
+invariant gl_Position;
+
 void main()
 {
     //mat4 transformMatrix = (cameraData.viewproj * inConstants.render_matrix);
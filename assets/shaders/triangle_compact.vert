@@ -0,0 +1,40 @@
+#version 450
+
+// quantized vertex layouts, positions come relative to the mesh bounds and the model matrix undoes it
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec2 vNormal;
+layout (location = 3) in vec2 vTexCoord;
+
+layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec2 texCoord;
+
+layout(set = 0, binding = 0) uniform CameraBuffer {
+    mat4 view;
+    mat4 proj;
+    mat4 viewproj;
+} cameraData;
+
+layout(push_constant) uniform constants {
+    mat4 model;
+} inConstants;
+
+// matches the depth prepass
+invariant gl_Position;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    mat4 transformMatrix = (cameraData.viewproj * inConstants.model);
+    gl_Position = transformMatrix * vec4(vPosition, 1.0f);
+    // the compact layouts carry no vertex color, the normal stands in for it
+    outColor = decodeOctahedral(vNormal) * 0.5f + 0.5f;
+    texCoord = vTexCoord;
+}
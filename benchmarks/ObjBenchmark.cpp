@@ -0,0 +1,116 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+#include "core/ObjLoader.hpp"
+#include "core/ThreadPool.hpp"
+
+// Writes a grid of quads with positions, uvs and normals as an OBJ file and times ObjLoader against tinyobjloader
+// reading it. Usage: obj_benchmark [quads] [path]
+
+namespace {
+
+// the best of a few runs, in milliseconds
+template<typename Function>
+double measure(Function function) {
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// a square grid of at least quads faces over a gentle wave, every vertex with its own uv and normal
+bool writeGrid(const char *path, uint32_t quads) {
+    FILE *file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    uint32_t side = 1;
+    while (side * side < quads) {
+        side++;
+    }
+    uint32_t vertices = side + 1;
+    std::fprintf(file, "# %u x %u quads\no grid\n", side, side);
+    for (uint32_t y = 0; y < vertices; y++) {
+        for (uint32_t x = 0; x < vertices; x++) {
+            float height = float((x * 7 + y * 13) % 17) * 0.01f;
+            std::fprintf(file, "v %.4f %.4f %.4f\n", float(x) * 0.1f, height, float(y) * 0.1f);
+        }
+    }
+    for (uint32_t y = 0; y < vertices; y++) {
+        for (uint32_t x = 0; x < vertices; x++) {
+            std::fprintf(file, "vt %.5f %.5f\n", float(x) / float(side), float(y) / float(side));
+        }
+    }
+    for (uint32_t y = 0; y < vertices; y++) {
+        for (uint32_t x = 0; x < vertices; x++) {
+            std::fprintf(file, "vn 0.0000 1.0000 0.0000\n");
+        }
+    }
+    for (uint32_t y = 0; y < side; y++) {
+        for (uint32_t x = 0; x < side; x++) {
+            uint32_t corner = y * vertices + x + 1;
+            uint32_t a = corner, b = corner + 1, c = corner + vertices + 1, d = corner + vertices;
+            std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+}
+
+int main(int argc, char **argv) {
+    uint32_t quads = argc > 1 ? uint32_t(std::stoul(argv[1])) : 2000000;
+    std::string path = argc > 2 ? argv[2] : "obj_benchmark.obj";
+
+    auto writeStart = std::chrono::steady_clock::now();
+    if (!writeGrid(path.c_str(), quads)) {
+        std::cout << "Failed to write " << path << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> writeTime = std::chrono::steady_clock::now() - writeStart;
+    std::cout << "Wrote " << path << " in " << writeTime.count() << " ms" << std::endl;
+
+    size_t objLoaderTriangles = 0;
+    double objLoaderTime = measure([&] {
+        ObjData data;
+        if (!ObjLoader::load(path.c_str(), data)) {
+            std::cout << "ObjLoader failed to load " << path << std::endl;
+        }
+        objLoaderTriangles = data.corners.size() / 3;
+    });
+    std::cout << "ObjLoader with " << ThreadPool::global().getThreadCount() << " workers: " << objLoaderTime << " ms, "
+              << objLoaderTriangles << " triangles" << std::endl;
+
+    size_t tinyobjTriangles = 0;
+    double tinyobjTime = measure([&] {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warning;
+        std::string error;
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, path.c_str(), nullptr, true)) {
+            std::cout << "tinyobjloader failed to load " << path << ": " << error << std::endl;
+        }
+        tinyobjTriangles = 0;
+        for (const auto &shape : shapes) {
+            tinyobjTriangles += shape.mesh.indices.size() / 3;
+        }
+    });
+    std::cout << "tinyobjloader: " << tinyobjTime << " ms, " << tinyobjTriangles << " triangles" << std::endl;
+    std::cout << "Speedup: " << tinyobjTime / objLoaderTime << "x" << std::endl;
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,106 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "glm/glm.hpp"
+#include "core/Texture.hpp"
+#include "core/TextureSampler.hpp"
+
+// Times TextureSampler against a bilinear made of four Texture::getPixelColor reads a uv, for random uvs and for a
+// coherent walk across the texture. Usage: sampler_benchmark [texture size] [uv count]
+
+namespace {
+
+// the best of a few runs, in milliseconds
+template<typename Function>
+double measure(Function function) {
+    double best = 1e30;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+glm::vec4 samplePerCall(const Texture &texture, glm::vec2 uv) {
+    float x = glm::clamp(uv.x, 0.0f, 1.0f) * float(texture.width - 1);
+    float y = glm::clamp(uv.y, 0.0f, 1.0f) * float(texture.height - 1);
+    int x0 = std::min(int(x), std::max(texture.width - 2, 0));
+    int y0 = std::min(int(y), std::max(texture.height - 2, 0));
+    int x1 = std::min(x0 + 1, texture.width - 1);
+    int y1 = std::min(y0 + 1, texture.height - 1);
+    float fx = x - float(x0);
+    float fy = y - float(y0);
+    glm::vec4 top = glm::mix(texture.getPixelColor(x0, y0), texture.getPixelColor(x1, y0), fx);
+    glm::vec4 bottom = glm::mix(texture.getPixelColor(x0, y1), texture.getPixelColor(x1, y1), fx);
+    return glm::mix(top, bottom, fy);
+}
+
+void report(const char *name, double milliseconds, size_t count) {
+    std::cout << "  " << name << ": " << milliseconds << " ms, " << double(count) / milliseconds / 1000.0 << " M uvs/s" << std::endl;
+}
+
+}
+
+int main(int argc, char **argv) {
+    uint32_t size = argc > 1 ? uint32_t(std::stoul(argv[1])) : 4096;
+    size_t count = argc > 2 ? size_t(std::stoull(argv[2])) : 1 << 20;
+
+    std::mt19937 random(1337);
+    std::vector<uint8_t> texels(size_t(size) * size * 4);
+    for (auto &texel : texels) {
+        texel = uint8_t(random());
+    }
+    Texture texture("benchmark");
+    texture.width = int(size);
+    texture.height = int(size);
+    texture.nrChannels = 4;
+    texture.data = texels.data();
+    TextureSampler linear(texture, TexelLayout::LINEAR);
+    TextureSampler tiled(texture, TexelLayout::TILED);
+
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<glm::vec2> randomUvs(count);
+    for (auto &uv : randomUvs) {
+        uv = {distribution(random), distribution(random)};
+    }
+    // uvs sweeping the texture row by row, a texel apart, like heights queried along a path
+    std::vector<glm::vec2> walkUvs(count);
+    for (size_t i = 0; i < count; i++) {
+        walkUvs[i] = glm::vec2(float(i % size) + 0.3f, float(i / size % size) + 0.7f) / float(size);
+    }
+
+    std::vector<glm::vec4> colors(count);
+    std::vector<float> channel(count);
+    std::cout << "Texture " << size << "x" << size << ", " << count << " uvs" << std::endl;
+    for (auto [name, uvs] : {std::pair{"random", &randomUvs}, std::pair{"walk", &walkUvs}}) {
+        std::cout << name << ":" << std::endl;
+        report("per call", measure([&] {
+            for (size_t i = 0; i < count; i++) {
+                colors[i] = samplePerCall(texture, (*uvs)[i]);
+            }
+        }), count);
+        report("linear rgba", measure([&] { linear.sample(uvs->data(), count, colors.data()); }), count);
+        report("linear one channel", measure([&] { linear.sample(uvs->data(), count, 0, channel.data()); }), count);
+        report("tiled rgba", measure([&] { tiled.sample(uvs->data(), count, colors.data()); }), count);
+        report("tiled one channel", measure([&] { tiled.sample(uvs->data(), count, 0, channel.data()); }), count);
+
+        // the sampler filters every uv the same as the per call bilinear
+        float largestError = 0.0f;
+        tiled.sample(uvs->data(), count, colors.data());
+        for (size_t i = 0; i < count; i += 97) {
+            glm::vec4 error = glm::abs(colors[i] - samplePerCall(texture, (*uvs)[i]));
+            largestError = std::max({largestError, error.x, error.y, error.z, error.w});
+        }
+        std::cout << "  largest difference to per call: " << largestError << std::endl;
+    }
+
+    return 0;
+}
@@ -1,12 +1,80 @@
 //
 // Created by f0xeri on 30.12.2022.
 //
-#define TINYOBJLOADER_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "Application.hpp"
 #include "Shader.hpp"
 #include "Camera.hpp"
 
+#include <cfloat>
+
+namespace {
+
+const uint32_t TERRAIN_HEIGHTMAP_SIZE = 1024;
+// 63 x 63 patches of 2 x 2 units, scaled up by the model matrix
+const int TERRAIN_PATCH_GRID = 64;
+const float TERRAIN_SCALE = 4.0f;
+const float TERRAIN_HEIGHT_SCALE = 40.0f;
+const float TERRAIN_MAX_TESS_LEVEL = 64.0f;
+// chunked lod terrain of 2^(lods - 1) leaves a side, every node is a grid of TERRAIN_GRID_SIZE quads
+const float CDLOD_TERRAIN_SIZE = 1024.0f;
+const glm::vec3 CDLOD_TERRAIN_ORIGIN = glm::vec3(-CDLOD_TERRAIN_SIZE * 0.5f, -50.0f, -CDLOD_TERRAIN_SIZE * 0.5f);
+const uint32_t CDLOD_LOD_COUNT = 6;
+const uint32_t TERRAIN_GRID_SIZE = 32;
+// the clipmap repeats the heightmap with a texel per unit on the finest level
+const uint32_t CLIPMAP_LEVEL_COUNT = 6;
+const float CLIPMAP_TEXEL_SIZE = 1.0f;
+const float CLIPMAP_BASE_HEIGHT = -50.0f;
+
+// the benchmark cars stand between these distances in front of the starting camera. At 1 px error on a 720 px high view
+// the car takes its lods 1 to 4 from about 140, 350, 740 and 1280 units away, so the far ones draw the coarsest
+const float LOD_BENCHMARK_NEAR = 10.0f;
+const float LOD_BENCHMARK_FAR = 1600.0f;
+const float LOD_BENCHMARK_FAR_PLANE = 1700.0f;
+// every period of this many frames is logged, the periods alternate between selecting lods and drawing full meshes
+const uint32_t LOD_BENCHMARK_LOG_FRAMES = 300;
+
+std::string getClipmapMeshName(ClipmapMesh mesh) {
+    return "terrainClipmap" + std::to_string(static_cast<uint32_t>(mesh));
+}
+
+glm::mat4 getTerrainModel() {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -50.0f, 0.0f));
+    return glm::scale(model, glm::vec3(TERRAIN_SCALE, 1.0f, TERRAIN_SCALE));
+}
+
+const VertexLayout vertexLayouts[] = {VertexLayout::STANDARD, VertexLayout::HALF, VertexLayout::COMPACT};
+// triangle.frag only samples the texture at binding 1, the one at binding 0 is never requested and keeps its mip tail
+const char *MESH_TEXTURE = "cvpiTexture2";
+
+// every vertex layout gets a color and a depth only pipeline, quantized layouts use the compact vertex shader
+std::string getPipelineName(VertexLayout layout, bool depthOnly) {
+    std::string name = depthOnly ? "depth" : "default";
+    if (layout == VertexLayout::HALF) {
+        name += "_half";
+    }
+    else if (layout == VertexLayout::COMPACT) {
+        name += "_compact";
+    }
+    return name;
+}
+
+// what the scene knows about an instance in the current frame, the lod is carried over to the next one for the hysteresis
+struct MeshInstanceState {
+    uint32_t id = UINT32_MAX;
+    glm::mat4 model = glm::mat4(1.0f);
+    Bounds worldBounds;
+    BoundingSphere worldSphere;
+    // false when the whole mesh is outside the frustum, nothing of it is culled or drawn then
+    bool visible = true;
+    uint32_t lod = 0;
+    // slot of the meshlet draws when culled on the GPU
+    uint32_t drawSlot = VulkanBackend::NO_DRAW_SLOT;
+    std::vector<IndexRange> visibleRanges;
+};
+
+}
+
 Application::Application(int width, int height, const char* title) {
     this->width = width;
     this->height = height;
@@ -44,59 +112,388 @@ Application::~Application() {
 }
 
 void Application::initScene() {
-    Shader shader = {};
-    shader.name = "default";
-    shader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/triangle.vert.spv", ShaderStage::VERTEX));
-    shader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/triangle.frag.spv", ShaderStage::FRAGMENT));
-    shader.descriptorBinding = DescriptorBinding();
-    shader.descriptorBinding.addUniform(0, "cameraBuffer", UniformType::UNIFORM_BUFFER, sizeof(CameraData));
-    shader.constants.push_back({"modelBuffer", sizeof(glm::mat4), 0, {ShaderStage::VERTEX}});
-    vulkanBackend->createShader(shader);
-
-    Mesh cvpiMesh;
-    cvpiMesh.loadFromObj("assets/cvpi.obj");
-    vulkanBackend->addMesh("cvpi", cvpiMesh);
-    vulkanBackend->addMesh("cvpi2", cvpiMesh);
-
-    vulkanBackend->meshes["cvpi2"].model = glm::translate(glm::mat4(1.0f), glm::vec3(-60.0f, 0.0f, -20.0f));
-    vulkanBackend->meshes["cvpi"].model = glm::translate(glm::mat4(1.0f), glm::vec3(60.0f, 0.0f, -20.0f));
+    for (auto layout : vertexLayouts) {
+        const char *vertexShader = layout == VertexLayout::STANDARD ? "assets/shaders/triangle.vert.spv" : "assets/shaders/triangle_compact.vert.spv";
+        Shader shader = {};
+        shader.name = getPipelineName(layout, false);
+        shader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile(vertexShader, ShaderStage::VERTEX));
+        shader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/triangle.frag.spv", ShaderStage::FRAGMENT));
+        shader.descriptorBinding = DescriptorBinding();
+        shader.descriptorBinding.addUniform(0, "cameraBuffer", UniformType::UNIFORM_BUFFER, sizeof(CameraData));
+        shader.constants.push_back({"modelBuffer", sizeof(glm::mat4), 0, {ShaderStage::VERTEX}});
+        shader.vertexLayout = layout;
+        vulkanBackend->createShader(shader);
+        materialTextures[shader.name] = {MESH_TEXTURE};
+
+        Shader depthShader = shader;
+        depthShader.name = getPipelineName(layout, true);
+        depthShader.stagesInfo = {vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/depth.vert.spv", ShaderStage::VERTEX)};
+        depthShader.depthOnly = true;
+        vulkanBackend->createShader(depthShader);
+    }
+
+    if (terrainMode == TerrainMode::TESSELLATION && !vulkanBackend->isTessellationSupported()) {
+        std::cout << "Tessellation shaders are not supported, terrain falls back to CDLOD" << std::endl;
+        terrainMode = TerrainMode::CDLOD;
+    }
+    if (terrainMode != TerrainMode::NONE) {
+        heightmap = Heightmap::generate(TERRAIN_HEIGHTMAP_SIZE, 1337);
+    }
+    if (terrainMode == TerrainMode::TESSELLATION) {
+        Shader terrainShader = {};
+        terrainShader.name = "terrain";
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.vert.spv", ShaderStage::VERTEX));
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.tesc.spv", ShaderStage::TESSELLATION_CONTROL));
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.tese.spv", ShaderStage::TESSELLATION_EVALUATION));
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.frag.spv", ShaderStage::FRAGMENT));
+        terrainShader.descriptorBinding = DescriptorBinding();
+        terrainShader.descriptorBinding.addUniform(0, "cameraBuffer", UniformType::UNIFORM_BUFFER, sizeof(CameraData));
+        terrainShader.constants.push_back({"terrainConstants", sizeof(TerrainConstants), 0,
+                                           {ShaderStage::VERTEX, ShaderStage::TESSELLATION_CONTROL, ShaderStage::TESSELLATION_EVALUATION}});
+        terrainShader.patchControlPoints = 4;
+        vulkanBackend->createShader(terrainShader);
+        // the patches are only corners, the tessellator adds the vertices where the screen needs them
+        terrainMesh = vulkanBackend->addMesh("terrain", Mesh::generateTerrainPatch(TERRAIN_PATCH_GRID));
+        // the patch uvs cover the heightmap over 2 * TERRAIN_PATCH_GRID units
+        float texelSize = 2.0f * TERRAIN_PATCH_GRID * TERRAIN_SCALE / float(TERRAIN_HEIGHTMAP_SIZE - 1);
+        heightmapTexels = heightmap.packTexels(TERRAIN_HEIGHT_SCALE, texelSize);
+    }
+    else if (terrainMode == TerrainMode::CDLOD) {
+        Shader terrainShader = {};
+        terrainShader.name = "terrainCdlod";
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain_cdlod.vert.spv", ShaderStage::VERTEX));
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.frag.spv", ShaderStage::FRAGMENT));
+        terrainShader.descriptorBinding = DescriptorBinding();
+        terrainShader.descriptorBinding.addUniform(0, "cameraBuffer", UniformType::UNIFORM_BUFFER, sizeof(CameraData));
+        terrainShader.constants.push_back({"terrainNodeConstants", sizeof(TerrainNodeConstants), 0, {ShaderStage::VERTEX}});
+        terrainShader.instanceLayout = InstanceLayout::TERRAIN_NODE;
+        vulkanBackend->createShader(terrainShader);
+        // one grid for every node, scaled to the node's size by the vertex shader
+        terrainMesh = vulkanBackend->addMesh("terrainGrid", Mesh::generateTerrainGrid(TERRAIN_GRID_SIZE));
+        terrainQuadtree = TerrainQuadtree(heightmap, CDLOD_TERRAIN_ORIGIN, CDLOD_TERRAIN_SIZE, TERRAIN_HEIGHT_SCALE, CDLOD_LOD_COUNT);
+        heightmapTexels = heightmap.packTexels(TERRAIN_HEIGHT_SCALE, CDLOD_TERRAIN_SIZE / float(TERRAIN_HEIGHTMAP_SIZE - 1));
+        Texture heightmapTexture("heightmap");
+        heightmapTexture.width = static_cast<int>(heightmap.getSize());
+        heightmapTexture.height = static_cast<int>(heightmap.getSize());
+        heightmapTexture.nrChannels = 4;
+        heightmapTexture.data = heightmapTexels.data();
+        heightmapSampler = TextureSampler(heightmapTexture);
+    }
+    else if (terrainMode == TerrainMode::CLIPMAP) {
+        Shader terrainShader = {};
+        terrainShader.name = "terrainClipmap";
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain_clipmap.vert.spv", ShaderStage::VERTEX));
+        terrainShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/terrain.frag.spv", ShaderStage::FRAGMENT));
+        terrainShader.descriptorBinding = DescriptorBinding();
+        terrainShader.descriptorBinding.addUniform(0, "cameraBuffer", UniformType::UNIFORM_BUFFER, sizeof(CameraData));
+        terrainShader.constants.push_back({"clipmapConstants", sizeof(ClipmapConstants), 0, {ShaderStage::VERTEX}});
+        terrainShader.instanceLayout = InstanceLayout::TERRAIN_NODE;
+        vulkanBackend->createShader(terrainShader);
+        terrainClipmap = TerrainClipmap(heightmap, CLIPMAP_TEXEL_SIZE, TERRAIN_HEIGHT_SCALE, CLIPMAP_BASE_HEIGHT, CLIPMAP_LEVEL_COUNT);
+        for (uint32_t mesh = 0; mesh < CLIPMAP_MESH_COUNT; mesh++) {
+            glm::uvec2 size = getClipmapMeshSize(ClipmapMesh(mesh), terrainClipmap.getTextureSize());
+            clipmapMeshes[mesh] = vulkanBackend->addMesh(getClipmapMeshName(ClipmapMesh(mesh)), Mesh::generateTerrainBlock(size.x, size.y));
+        }
+        // the levels around the starting position are in the texture when it is created, the frames only add what
+        // comes into view
+        std::vector<ClipmapRegion> regions;
+        terrainClipmap.update(glm::vec3(0.0f, 10.0f, 100.0f), regions);
+    }
+
+    MeshImportOptions importOptions;
+    importOptions.vertexLayout = VertexLayout::COMPACT;
+    importOptions.positionStream = true;
+    // read and uploaded in the background, both cars share one set of buffers and show up once it is ready
+    std::string cvpi = vulkanBackend->loadMeshAsync("cvpi", "assets/cvpi.obj", importOptions);
+    std::vector<glm::vec3> cvpiPositions = {glm::vec3(60.0f, 0.0f, -20.0f), glm::vec3(-60.0f, 0.0f, -20.0f)};
+    if (lodBenchmarkInstances > 0) {
+        // evenly spaced in distance from the camera and scattered across the view at each distance
+        cvpiPositions.clear();
+        for (uint32_t i = 0; i < lodBenchmarkInstances; i++) {
+            float distance = LOD_BENCHMARK_NEAR + (LOD_BENCHMARK_FAR - LOD_BENCHMARK_NEAR) * (float(i) + 0.5f) / float(lodBenchmarkInstances);
+            float across = glm::fract(float(i) * 0.618034f) * 2.0f - 1.0f;
+            cvpiPositions.emplace_back(across * distance, 0.0f, 100.0f - distance);
+        }
+    }
+    placeOnTerrain(cvpiPositions);
+    for (const auto &position : cvpiPositions) {
+        vulkanBackend->addInstance({cvpi, "", glm::translate(glm::mat4(1.0f), position)});
+    }
+}
+
+void Application::placeOnTerrain(std::vector<glm::vec3> &positions) const {
+    if (terrainMode != TerrainMode::CDLOD) {
+        return;
+    }
+    std::vector<glm::vec2> uvs(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        uvs[i] = (glm::vec2(positions[i].x, positions[i].z) - glm::vec2(CDLOD_TERRAIN_ORIGIN.x, CDLOD_TERRAIN_ORIGIN.z)) / CDLOD_TERRAIN_SIZE;
+    }
+    std::vector<glm::vec4> texels(positions.size());
+    heightmapSampler.sample(uvs.data(), uvs.size(), texels.data());
+    for (size_t i = 0; i < positions.size(); i++) {
+        // the high and low bytes of the height are filtered apart, which adds up to the filtered height
+        float height = (texels[i].x * 256.0f + texels[i].y) * (1.0f / 65535.0f);
+        positions[i].y = CDLOD_TERRAIN_ORIGIN.y + height * TERRAIN_HEIGHT_SCALE;
+    }
 }
 
 void Application::run() {
     glm::vec3 camPos = { 0.f,-10.0f,-100.f };
+    std::vector<MeshInstanceState> instances;
+    TerrainSelection terrainSelection;
+    ClipmapSelection clipmapSelection;
+    std::vector<ClipmapRegion> clipmapRegions;
+    std::vector<TextureRegion> textureRegions;
+    // triangles of the lods drawn and of the full meshes of the same instances, summed over the benchmark's frames
+    uint64_t lodTriangles = 0;
+    uint64_t fullTriangles = 0;
+    uint64_t visibleInstances = 0;
+    double gpuFrameTime = 0.0;
+    float farPlane = lodBenchmarkInstances > 0 ? LOD_BENCHMARK_FAR_PLANE : 200.0f;
     while (!glfwWindowShouldClose(mainWindow.get())) {
         glfwPollEvents();
         vulkanBackend->beginFrame();
+        bool benchmarkFullMeshes = lodBenchmarkInstances > 0 && (vulkanBackend->frameNumber / LOD_BENCHMARK_LOG_FRAMES) % 2 == 1;
 
         glm::mat4 view = glm::translate(glm::mat4(1.f), camPos);
-        glm::mat4 projection = glm::perspective(glm::radians(70.f), (float)width / height, 0.1f, 200.0f);
+        glm::mat4 projection = glm::perspective(glm::radians(70.f), (float)width / height, 0.1f, farPlane);
         projection[1][1] *= -1;
+        Frustum frustum = Frustum::fromMatrix(projection * view);
+        float projectionScale = std::abs(projection[1][1]) * height * 0.5f;
+
+        instances.resize(vulkanBackend->instances.size());
+        size_t instanceIndex = 0;
+        for (auto &sceneInstance : vulkanBackend->instances) {
+            auto &instance = instances[instanceIndex++];
+            auto &mesh = vulkanBackend->meshes.at(sceneInstance.second.mesh);
+            // the lod of another instance says nothing about this one
+            if (instance.id != sceneInstance.first) {
+                instance.id = sceneInstance.first;
+                instance.lod = 0;
+            }
+            instance.model = glm::rotate(sceneInstance.second.model, glm::radians(vulkanBackend->frameNumber * 0.4f), glm::vec3(0, 1, 0));
+            instance.worldBounds = mesh.bounds.transform(instance.model);
+            instance.worldSphere = mesh.boundingSphere.transform(instance.model);
+            instance.visibleRanges.clear();
+            instance.drawSlot = VulkanBackend::NO_DRAW_SLOT;
+            instance.visible = mesh.state == MeshState::READY && !(sceneInstance.second.flags & MESH_INSTANCE_HIDDEN) &&
+                               frustum.intersectsSphere(instance.worldSphere.center, instance.worldSphere.radius) &&
+                               frustum.intersectsBox(instance.worldBounds.getCenter(), instance.worldBounds.getHalfExtent());
+            if (!instance.visible) {
+                continue;
+            }
+            // the textures of the instance's material are assumed to span the mesh once, so they need about as many
+            // texels as it is pixels wide. The backend keeps the finest request of the frame for every texture
+            float distance = glm::length(instance.worldSphere.center + camPos) - instance.worldSphere.radius;
+            float texelsAcross = distance > 0.0f ? 2.0f * instance.worldSphere.radius * projectionScale / distance : FLT_MAX;
+            std::string material = sceneInstance.second.material.empty() ? getPipelineName(mesh.vertexLayout, false) : sceneInstance.second.material;
+            auto textures = materialTextures.find(material);
+            if (textures != materialTextures.end()) {
+                for (const auto &texture : textures->second) {
+                    vulkanBackend->requestTextureDetail(texture, texelsAcross);
+                }
+            }
+            if (!(sceneInstance.second.flags & MESH_INSTANCE_NO_LOD) && !benchmarkFullMeshes) {
+                instance.lod = mesh.selectLod(instance.worldSphere, -camPos, projectionScale, lodPixelError, instance.lod);
+            }
+            else {
+                instance.lod = 0;
+            }
+            if (lodBenchmarkInstances > 0 && mesh.getLodCount() > 0) {
+                lodTriangles += mesh.getLods()[instance.lod].indexCount / 3;
+                fullTriangles += mesh.getLods()[0].indexCount / 3;
+                visibleInstances++;
+            }
+            // meshlet bounds are in the space of the unquantized positions, so without the dequantization transform
+            auto cullView = MeshletCullView::create(frustum, -camPos, instance.model);
+            // meshlets only exist for the full mesh, a coarser lod is drawn as a single range
+            if (instance.lod > 0) {
+                const MeshLod &lod = mesh.getLods()[instance.lod];
+                instance.visibleRanges.push_back({lod.indexOffset, lod.indexCount});
+                continue;
+            }
+            if (mesh.meshletCount > 0 && meshletCulling == MeshletCulling::GPU) {
+                instance.drawSlot = vulkanBackend->cullMeshlets(mesh, cullView.getConstants(mesh.meshletCount));
+            }
+            // instances beyond the draw slots of their mesh fall back to the CPU
+            if (mesh.meshletCount > 0 && meshletCulling != MeshletCulling::NONE && instance.drawSlot == VulkanBackend::NO_DRAW_SLOT) {
+                MeshletBuilder::cull(mesh, cullView, instance.visibleRanges);
+            }
+        }
+        // the backend has the time of the previous frame, the first frame of a period counts the last one of the period before
+        if (lodBenchmarkInstances > 0) {
+            gpuFrameTime += vulkanBackend->gpuFrameTime;
+        }
+        if (lodBenchmarkInstances > 0 && vulkanBackend->frameNumber % LOD_BENCHMARK_LOG_FRAMES == LOD_BENCHMARK_LOG_FRAMES - 1) {
+            // nothing is counted before the cars are loaded
+            if (fullTriangles > 0) {
+                std::cout << "Lod benchmark " << (benchmarkFullMeshes ? "without lods: " : "with lods: ") << visibleInstances / LOD_BENCHMARK_LOG_FRAMES << " of "
+                          << lodBenchmarkInstances << " instances visible, " << lodTriangles / LOD_BENCHMARK_LOG_FRAMES << " of "
+                          << fullTriangles / LOD_BENCHMARK_LOG_FRAMES << " triangles a frame ("
+                          << 100.0 * double(lodTriangles) / double(fullTriangles) << "%) at " << lodPixelError << " px error, "
+                          << gpuFrameTime / LOD_BENCHMARK_LOG_FRAMES << " ms GPU time a frame" << std::endl;
+            }
+            lodTriangles = 0;
+            fullTriangles = 0;
+            visibleInstances = 0;
+            gpuFrameTime = 0.0;
+        }
+        if (terrainMode == TerrainMode::CLIPMAP) {
+            // only the rows and columns that came into view are copied, before the render pass
+            clipmapRegions.clear();
+            terrainClipmap.update(-camPos, clipmapRegions);
+            textureRegions.clear();
+            for (const auto &region : clipmapRegions) {
+                textureRegions.push_back({region.level, region.x, region.y, region.width, region.height,
+                                          terrainClipmap.getTexel(region.level, region.x, region.y), terrainClipmap.getTextureSize()});
+            }
+            if (!vulkanBackend->updateTexture("terrainClipmap", textureRegions)) {
+                terrainClipmap.invalidate();
+            }
+            terrainClipmap.select(frustum, clipmapSelection);
+        }
+        vulkanBackend->beginRenderPass();
 
-        vulkanBackend->bindPipeline("default");
-        vulkanBackend->bindDescriptorSets();
         CameraData cameraData = {view, projection, projection * view};
         vulkanBackend->setUniformBuffer("cameraBuffer", &cameraData, sizeof(CameraData));
-        for (auto &mesh : vulkanBackend->meshes) {
-            glm::mat4 model = glm::rotate(mesh.second.model, glm::radians(vulkanBackend->frameNumber * 0.4f), glm::vec3(0, 1, 0));
-            vulkanBackend->pushConstants(&model, sizeof(glm::mat4), ShaderStage::VERTEX);
-            vulkanBackend->drawMesh(mesh.second);
+        auto drawMeshes = [&](bool depthOnly) {
+            std::string boundPipeline;
+            size_t instanceIndex = 0;
+            for (auto &sceneInstance : vulkanBackend->instances) {
+                const auto &instance = instances[instanceIndex++];
+                auto &mesh = vulkanBackend->meshes.at(sceneInstance.second.mesh);
+                if (!instance.visible) {
+                    continue;
+                }
+                if (depthOnly && (!mesh.positionStream || (sceneInstance.second.flags & MESH_INSTANCE_NO_DEPTH_PREPASS))) {
+                    continue;
+                }
+                std::string pipeline = getPipelineName(mesh.vertexLayout, depthOnly);
+                if (!depthOnly && !sceneInstance.second.material.empty()) {
+                    pipeline = sceneInstance.second.material;
+                }
+                if (pipeline != boundPipeline) {
+                    vulkanBackend->bindPipeline(pipeline);
+                    vulkanBackend->bindDescriptorSets();
+                    boundPipeline = pipeline;
+                }
+                glm::mat4 model = instance.model * mesh.getDequantizationTransform();
+                vulkanBackend->pushConstants(&model, sizeof(glm::mat4), ShaderStage::VERTEX);
+                bool culled = mesh.meshletCount > 0 && mesh.indexCount > 0 && meshletCulling != MeshletCulling::NONE;
+                if (instance.lod > 0) {
+                    vulkanBackend->drawMeshRanges(mesh, instance.visibleRanges, depthOnly);
+                }
+                else if (culled && instance.drawSlot != VulkanBackend::NO_DRAW_SLOT) {
+                    vulkanBackend->drawMeshletsIndirect(mesh, instance.drawSlot, depthOnly);
+                }
+                else if (culled) {
+                    vulkanBackend->drawMeshRanges(mesh, instance.visibleRanges, depthOnly);
+                }
+                else if (depthOnly) {
+                    vulkanBackend->drawMeshDepth(mesh);
+                }
+                else if (mesh.indexCount > 0) {
+                    vulkanBackend->drawMeshIndexed(mesh);
+                }
+                else {
+                    vulkanBackend->drawMesh(mesh);
+                }
+            }
+        };
+        // depth prepass from the position streams first, the color pass then shades only the visible surface
+        if (depthPrepass) {
+            drawMeshes(true);
+        }
+        drawMeshes(false);
+        if (terrainMode == TerrainMode::TESSELLATION) {
+            auto &patchMesh = vulkanBackend->meshes.at(terrainMesh);
+            TerrainConstants terrainConstants = {getTerrainModel(), glm::vec4(-camPos, 1.0f), TERRAIN_HEIGHT_SCALE, terrainPixelsPerEdge,
+                                                 (float)height, TERRAIN_MAX_TESS_LEVEL};
+            vulkanBackend->bindPipeline("terrain");
+            vulkanBackend->bindDescriptorSets();
+            vulkanBackend->pushConstants(&terrainConstants, sizeof(TerrainConstants),
+                                         {ShaderStage::VERTEX, ShaderStage::TESSELLATION_CONTROL, ShaderStage::TESSELLATION_EVALUATION});
+            vulkanBackend->drawMeshIndexed(patchMesh);
+        }
+        else if (terrainMode == TerrainMode::CDLOD) {
+            auto &gridMesh = vulkanBackend->meshes.at(terrainMesh);
+            terrainQuadtree.select(frustum, -camPos, terrainSelection);
+            TerrainNodeConstants terrainConstants = {glm::vec4(-camPos, 1.0f), glm::vec4(CDLOD_TERRAIN_ORIGIN, CDLOD_TERRAIN_SIZE), TERRAIN_HEIGHT_SCALE,
+                                                     float(TERRAIN_GRID_SIZE)};
+            vulkanBackend->bindPipeline("terrainCdlod");
+            vulkanBackend->bindDescriptorSets();
+            vulkanBackend->pushConstants(&terrainConstants, sizeof(TerrainNodeConstants), ShaderStage::VERTEX);
+            // whole nodes draw the full grid, the partly refined ones a quarter of it per quadrant
+            const auto &nodes = terrainSelection.nodes;
+            vulkanBackend->drawMeshInstanced(gridMesh, {0, gridMesh.indexCount}, nodes.data(), uint32_t(nodes.size()), sizeof(TerrainNode));
+            uint32_t quadrantIndexCount = gridMesh.indexCount / 4;
+            for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+                const auto &quadrantNodes = terrainSelection.quadrants[quadrant];
+                vulkanBackend->drawMeshInstanced(gridMesh, {quadrant * quadrantIndexCount, quadrantIndexCount}, quadrantNodes.data(),
+                                                 uint32_t(quadrantNodes.size()), sizeof(TerrainNode));
+            }
+        }
+        else if (terrainMode == TerrainMode::CLIPMAP) {
+            ClipmapConstants clipmapConstants = {TERRAIN_HEIGHT_SCALE, CLIPMAP_BASE_HEIGHT, float(terrainClipmap.getLevelCount())};
+            vulkanBackend->bindPipeline("terrainClipmap");
+            vulkanBackend->bindDescriptorSets();
+            vulkanBackend->pushConstants(&clipmapConstants, sizeof(ClipmapConstants), ShaderStage::VERTEX);
+            // one instanced draw per block mesh for all levels
+            for (uint32_t mesh = 0; mesh < CLIPMAP_MESH_COUNT; mesh++) {
+                auto &blockMesh = vulkanBackend->meshes.at(clipmapMeshes[mesh]);
+                const auto &blocks = clipmapSelection.blocks[mesh];
+                vulkanBackend->drawMeshInstanced(blockMesh, {0, blockMesh.indexCount}, blocks.data(), uint32_t(blocks.size()), sizeof(TerrainNode));
+            }
         }
         vulkanBackend->endFrame();
     }
 }
 
 void Application::initPipelines() {
+    // opaque color maps, a quarter of a byte per texel in BC1
+    TextureFormat colorFormat = vulkanBackend->isTextureCompressionBCSupported() ? TextureFormat::BC1 : TextureFormat::RGBA8;
+    // decoded on the workers, the materials sample placeholders until the images are resident
+    vulkanBackend->setTextureBudget(textureBudget);
+    // fills binding 0 for the materials, nothing samples it so only its tail is ever resident
     Texture cvpiTexture("cvpiTexture");
-    cvpiTexture.loadTextureFromFile("assets/cvpi.jpg");
+    cvpiTexture.format = colorFormat;
+    vulkanBackend->loadTextureAsync(cvpiTexture, "assets/cvpi.jpg", 0, true);
 
     Texture cvpiTexture2("cvpiTexture2");
-    cvpiTexture2.loadTextureFromFile("assets/cvpi2.jpg");
-    cvpiTexture2.name = "cvpiTexture2";
+    cvpiTexture2.format = colorFormat;
+    vulkanBackend->loadTextureAsync(cvpiTexture2, "assets/cvpi2.jpg", 1, true);
 
-
-    vulkanBackend->addTexture(cvpiTexture, 0);
-    vulkanBackend->addTexture(cvpiTexture2, 1);
+    if (terrainMode == TerrainMode::CLIPMAP) {
+        // the backend uploads the texels again from here when it recreates the texture with the swapchain
+        Texture clipmapTexture("terrainClipmap");
+        clipmapTexture.width = static_cast<int>(terrainClipmap.getTextureSize());
+        clipmapTexture.height = static_cast<int>(terrainClipmap.getTextureSize());
+        clipmapTexture.nrChannels = 4;
+        clipmapTexture.data = const_cast<uint8_t *>(terrainClipmap.getTexels().data());
+        clipmapTexture.srgb = false;
+        clipmapTexture.layers = terrainClipmap.getLevelCount();
+        clipmapTexture.mipmaps = false;
+        vulkanBackend->addTexture(clipmapTexture, 2);
+    }
+    else if (terrainMode != TerrainMode::NONE) {
+        Texture heightmapTexture("heightmap");
+        heightmapTexture.width = static_cast<int>(heightmap.getSize());
+        heightmapTexture.height = static_cast<int>(heightmap.getSize());
+        heightmapTexture.nrChannels = 4;
+        heightmapTexture.data = heightmapTexels.data();
+        heightmapTexture.srgb = false;
+        heightmapTexture.mipmaps = false;
+        vulkanBackend->addTexture(heightmapTexture, 2);
+    }
 
     vulkanBackend->createDescriptors(vulkanBackend->shaders["default"]);
-    vulkanBackend->createGraphicsPipeline("default", vulkanBackend->shaders["default"]);
+    for (auto &shader : vulkanBackend->shaders) {
+        vulkanBackend->createGraphicsPipeline(shader.first, shader.second);
+    }
+
+    Shader cullShader = {};
+    cullShader.name = "meshletCull";
+    cullShader.stagesInfo.push_back(vulkanBackend->getShaderLoader()->loadFromBinaryFile("assets/shaders/meshlet_cull.comp.spv", ShaderStage::COMPUTE));
+    vulkanBackend->createMeshletCullPipeline(cullShader);
 }
@@ -6,8 +6,13 @@
 #define VULKAN_EXPERIMENTS_APPLICATION_HPP
 
 #include <memory>
+#include <unordered_map>
 #include <GLFW/glfw3.h>
 #include "render/vulkan/VulkanBackend.hpp"
+#include "Heightmap.hpp"
+#include "TerrainQuadtree.hpp"
+#include "TerrainClipmap.hpp"
+#include "TextureSampler.hpp"
 
 struct CameraData {
     glm::mat4 view;
@@ -15,13 +20,86 @@ struct CameraData {
     glm::mat4 viewProj;
 };
 
+// pushed to the vertex and both tessellation stages of the terrain pipeline
+struct TerrainConstants {
+    glm::mat4 model;
+    glm::vec4 cameraPosition;
+    float heightScale;
+    float pixelsPerEdge;
+    float viewportHeight;
+    float maxTessLevel;
+};
+
+// pushed to the vertex stage of the chunked lod terrain pipeline
+struct TerrainNodeConstants {
+    glm::vec4 cameraPosition;
+    // xyz origin of the terrain, w its edge length
+    glm::vec4 terrain;
+    float heightScale;
+    float gridSize;
+};
+
+// pushed to the vertex stage of the clipmap terrain pipeline
+struct ClipmapConstants {
+    float heightScale;
+    float baseHeight;
+    float levelCount;
+};
+
+enum class TerrainMode {
+    NONE,
+    // one grid of patches tessellated on the GPU
+    TESSELLATION,
+    // quadtree of instanced grid nodes selected on the CPU, for terrains too large for one patch grid
+    CDLOD,
+    // rings around the camera with heights streamed into an array texture as it moves, for unbounded terrain
+    CLIPMAP,
+};
+
+enum class MeshletCulling {
+    NONE,
+    CPU,
+    GPU,
+};
+
 class Application {
 private:
     std::shared_ptr<GLFWwindow> mainWindow;
     std::unique_ptr<VulkanBackend> vulkanBackend;
+    Heightmap heightmap;
+    // the backend keeps the texture pointing at these to upload it again with the swapchain
+    std::vector<uint8_t> heightmapTexels;
+    // reads the texels the terrain shaders read, so that what is placed on the terrain sits on what is drawn
+    TextureSampler heightmapSampler;
+    TerrainQuadtree terrainQuadtree;
+    TerrainClipmap terrainClipmap;
+    // names the backend stored the terrain meshes under, a mesh with the same content added before keeps its own
+    std::string terrainMesh;
+    std::string clipmapMeshes[CLIPMAP_MESH_COUNT];
+    // streamed textures each material samples, their finer levels are requested by the size of the meshes drawn with it
+    std::unordered_map<std::string, std::vector<std::string>> materialTextures;
+
+    // moves the positions down or up onto the chunked lod terrain, the other terrain modes leave them where they are
+    void placeOnTerrain(std::vector<glm::vec3> &positions) const;
 public:
     int width;
     int height;
+    // lay down depth from the position-only streams before the color pass
+    bool depthPrepass = true;
+    // where back-facing and off-screen meshlets are dropped
+    MeshletCulling meshletCulling = MeshletCulling::GPU;
+    // largest simplification error in pixels a mesh instance may show before a finer lod is drawn
+    float lodPixelError = 1.0f;
+    // cars spread out in front of the camera past the distances of the coarsest lods instead of the two of the scene.
+    // Periods with and without lods alternate and log the share of the full resolution triangles submitted and the GPU
+    // frame time. 0 draws the regular scene. initScene reads it from the constructor, so the benchmark is switched on here
+    uint32_t lodBenchmarkInstances = 0;
+    // how the heightmap terrain is drawn, tessellation falls back to CDLOD when the device does not support it
+    TerrainMode terrainMode = TerrainMode::CDLOD;
+    // patch edges are split into segments of about this many pixels on screen
+    float terrainPixelsPerEdge = 12.0f;
+    // VRAM the streamed textures may take, less when the device has less left
+    uint64_t textureBudget = 256ull << 20;
     Application(int width, int height, const char* title);
     ~Application();
     void initScene();
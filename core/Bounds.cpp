@@ -0,0 +1,113 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "Bounds.hpp"
+#include "Mesh.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define BOUNDS_USE_SSE
+#endif
+
+namespace {
+
+// positions are followed by the normal, so 16 bytes can be loaded at every position and the fourth lane ignored
+static_assert(offsetof(Vertex, position) == 0 && sizeof(Vertex) >= 4 * sizeof(float));
+
+inline const float *getPosition(const Vertex *vertices, const uint32_t *indices, size_t i) {
+    return &vertices[indices ? indices[i] : i].position.x;
+}
+
+}
+
+Bounds Bounds::transform(const glm::mat4 &model) const {
+    glm::vec3 center = glm::vec3(model * glm::vec4(getCenter(), 1.0f));
+    glm::vec3 halfExtent = getHalfExtent();
+    glm::vec3 extent(0.0f);
+    for (int i = 0; i < 3; i++) {
+        extent += glm::abs(glm::vec3(model[i])) * halfExtent[i];
+    }
+    return {center - extent, center + extent};
+}
+
+BoundingSphere BoundingSphere::transform(const glm::mat4 &model) const {
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    return {glm::vec3(model * glm::vec4(center, 1.0f)), radius * scale};
+}
+
+Bounds computeBounds(const Vertex *vertices, const uint32_t *indices, size_t count) {
+    if (count == 0) {
+        return {};
+    }
+#ifdef BOUNDS_USE_SSE
+    // four accumulators so consecutive min/max do not wait on each other
+    __m128 first = _mm_loadu_ps(getPosition(vertices, indices, 0));
+    __m128 min[4] = {first, first, first, first};
+    __m128 max[4] = {first, first, first, first};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            __m128 position = _mm_loadu_ps(getPosition(vertices, indices, i + k));
+            min[k] = _mm_min_ps(min[k], position);
+            max[k] = _mm_max_ps(max[k], position);
+        }
+    }
+    for (; i < count; i++) {
+        __m128 position = _mm_loadu_ps(getPosition(vertices, indices, i));
+        min[0] = _mm_min_ps(min[0], position);
+        max[0] = _mm_max_ps(max[0], position);
+    }
+    alignas(16) float resultMin[4];
+    alignas(16) float resultMax[4];
+    _mm_store_ps(resultMin, _mm_min_ps(_mm_min_ps(min[0], min[1]), _mm_min_ps(min[2], min[3])));
+    _mm_store_ps(resultMax, _mm_max_ps(_mm_max_ps(max[0], max[1]), _mm_max_ps(max[2], max[3])));
+    return {glm::vec3(resultMin[0], resultMin[1], resultMin[2]), glm::vec3(resultMax[0], resultMax[1], resultMax[2])};
+#else
+    Bounds bounds;
+    bounds.min = bounds.max = vertices[indices ? indices[0] : 0].position;
+    for (size_t i = 1; i < count; i++) {
+        const glm::vec3 &position = vertices[indices ? indices[i] : i].position;
+        bounds.min = glm::min(bounds.min, position);
+        bounds.max = glm::max(bounds.max, position);
+    }
+    return bounds;
+#endif
+}
+
+BoundingSphere computeBoundingSphere(const Vertex *vertices, const uint32_t *indices, size_t count, const Bounds &bounds) {
+    BoundingSphere sphere;
+    sphere.center = bounds.getCenter();
+    float maxDistance = 0.0f;
+    size_t i = 0;
+#ifdef BOUNDS_USE_SSE
+    // four positions at a time transposed into x, y and z lanes
+    __m128 centerX = _mm_set1_ps(sphere.center.x);
+    __m128 centerY = _mm_set1_ps(sphere.center.y);
+    __m128 centerZ = _mm_set1_ps(sphere.center.z);
+    __m128 maxDistances = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(getPosition(vertices, indices, i));
+        __m128 y = _mm_loadu_ps(getPosition(vertices, indices, i + 1));
+        __m128 z = _mm_loadu_ps(getPosition(vertices, indices, i + 2));
+        __m128 w = _mm_loadu_ps(getPosition(vertices, indices, i + 3));
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        x = _mm_sub_ps(x, centerX);
+        y = _mm_sub_ps(y, centerY);
+        z = _mm_sub_ps(z, centerZ);
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        maxDistances = _mm_max_ps(maxDistances, distance);
+    }
+    alignas(16) float distances[4];
+    _mm_store_ps(distances, maxDistances);
+    maxDistance = std::max(std::max(distances[0], distances[1]), std::max(distances[2], distances[3]));
+#endif
+    for (; i < count; i++) {
+        glm::vec3 offset = vertices[indices ? indices[i] : i].position - sphere.center;
+        maxDistance = std::max(maxDistance, glm::dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(maxDistance);
+    return sphere;
+}
@@ -0,0 +1,40 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_BOUNDS_HPP
+#define VULKAN_EXPERIMENTS_BOUNDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+struct Vertex;
+
+// Axis aligned box
+struct Bounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 getHalfExtent() const { return (max - min) * 0.5f; }
+    // box around the transformed box
+    Bounds transform(const glm::mat4 &model) const;
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // the radius grows with the largest scale of model
+    BoundingSphere transform(const glm::mat4 &model) const;
+};
+
+// SIMD reductions over the positions of count vertices, or of the vertices referenced by count indices when
+// indices is not null
+Bounds computeBounds(const Vertex *vertices, const uint32_t *indices, size_t count);
+// sphere around the center of bounds that encloses every position
+BoundingSphere computeBoundingSphere(const Vertex *vertices, const uint32_t *indices, size_t count, const Bounds &bounds);
+
+
+#endif //VULKAN_EXPERIMENTS_BOUNDS_HPP
@@ -0,0 +1,64 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_FRUSTUM_HPP
+#define VULKAN_EXPERIMENTS_FRUSTUM_HPP
+
+#include "glm/glm.hpp"
+
+// Six planes facing inwards, a point p is inside when dot(plane, vec4(p, 1)) >= 0 for all of them
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // extract the planes from a view projection matrix with Vulkan's [0, 1] depth range
+    static Frustum fromMatrix(const glm::mat4 &viewProjection) {
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++) {
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        Frustum frustum{};
+        frustum.planes[0] = rows[3] + rows[0];
+        frustum.planes[1] = rows[3] - rows[0];
+        frustum.planes[2] = rows[3] + rows[1];
+        frustum.planes[3] = rows[3] - rows[1];
+        frustum.planes[4] = rows[2];
+        frustum.planes[5] = rows[3] - rows[2];
+        for (auto &plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // planes in the object space of model, distances to them stay in world units
+    Frustum toObjectSpace(const glm::mat4 &model) const {
+        glm::mat4 transposed = glm::transpose(model);
+        Frustum frustum{};
+        for (int i = 0; i < 6; i++) {
+            frustum.planes[i] = transposed * planes[i];
+        }
+        return frustum;
+    }
+
+    bool intersectsSphere(const glm::vec3 &center, float radius) const {
+        for (const auto &plane : planes) {
+            if (glm::dot(plane, glm::vec4(center, 1.0f)) < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // box given by its center and half extent, the planes may be unnormalized as long as they are in the box's space
+    bool intersectsBox(const glm::vec3 &center, const glm::vec3 &halfExtent) const {
+        for (const auto &plane : planes) {
+            if (glm::dot(plane, glm::vec4(center, 1.0f)) < -glm::dot(glm::abs(glm::vec3(plane)), halfExtent)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+#endif //VULKAN_EXPERIMENTS_FRUSTUM_HPP
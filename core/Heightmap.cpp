@@ -0,0 +1,123 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "Heightmap.hpp"
+
+namespace {
+
+float hashLattice(int32_t x, int32_t y, uint32_t seed) {
+    uint32_t hash = uint32_t(x) * 0x8da6b343u ^ uint32_t(y) * 0xd8163841u ^ seed * 0xcb1ab31fu;
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    hash *= 0x297a2d39u;
+    hash ^= hash >> 15;
+    return float(hash >> 8) * (1.0f / 16777216.0f);
+}
+
+// the lattice repeats every period cells, so that the noise tiles
+float valueNoise(float x, float y, uint32_t seed, int32_t period) {
+    float cellX = std::floor(x);
+    float cellY = std::floor(y);
+    int32_t ix = int32_t(cellX) % period;
+    int32_t iy = int32_t(cellY) % period;
+    float fx = x - cellX;
+    float fy = y - cellY;
+    // smoothstep weights hide the lattice in the slopes
+    float wx = fx * fx * (3.0f - 2.0f * fx);
+    float wy = fy * fy * (3.0f - 2.0f * fy);
+    int32_t nextX = (ix + 1) % period;
+    int32_t nextY = (iy + 1) % period;
+    float top = glm::mix(hashLattice(ix, iy, seed), hashLattice(nextX, iy, seed), wx);
+    float bottom = glm::mix(hashLattice(ix, nextY, seed), hashLattice(nextX, nextY, seed), wx);
+    return glm::mix(top, bottom, wy);
+}
+
+}
+
+Heightmap::Heightmap(uint32_t size, std::vector<uint16_t> heights) : size(size), heights(std::move(heights)) {
+}
+
+Heightmap Heightmap::generate(uint32_t size, uint32_t seed, uint32_t octaves) {
+    std::vector<float> values(size_t(size) * size);
+    // four cells of the first octave across the map, every octave fits a whole number of cells into it
+    const int32_t baseCells = 4;
+    float baseFrequency = float(baseCells) / float(size);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            float value = 0.0f;
+            float amplitude = 1.0f;
+            float frequency = baseFrequency;
+            for (uint32_t octave = 0; octave < octaves; octave++) {
+                value += valueNoise(float(x) * frequency, float(y) * frequency, seed + octave, baseCells << octave) * amplitude;
+                amplitude *= 0.5f;
+                frequency *= 2.0f;
+            }
+            values[size_t(y) * size + x] = value;
+        }
+    }
+    auto [minValue, maxValue] = std::minmax_element(values.begin(), values.end());
+    float offset = *minValue;
+    float scale = *maxValue > *minValue ? 65535.0f / (*maxValue - *minValue) : 0.0f;
+    std::vector<uint16_t> heights(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        heights[i] = uint16_t((values[i] - offset) * scale + 0.5f);
+    }
+    return {size, std::move(heights)};
+}
+
+Heightmap Heightmap::downsample() const {
+    uint32_t halfSize = std::max(size / 2, 1u);
+    std::vector<uint16_t> halfHeights(size_t(halfSize) * halfSize);
+    for (uint32_t y = 0; y < halfSize; y++) {
+        for (uint32_t x = 0; x < halfSize; x++) {
+            uint32_t sum = 0;
+            for (uint32_t texel = 0; texel < 4; texel++) {
+                sum += heights[size_t((y * 2 + texel / 2) % size) * size + (x * 2 + texel % 2) % size];
+            }
+            halfHeights[size_t(y) * halfSize + x] = uint16_t((sum + 2) / 4);
+        }
+    }
+    return {halfSize, std::move(halfHeights)};
+}
+
+float Heightmap::sample(float u, float v) const {
+    float x = std::clamp(u, 0.0f, 1.0f) * float(size - 1);
+    float y = std::clamp(v, 0.0f, 1.0f) * float(size - 1);
+    uint32_t x0 = std::min(uint32_t(x), size - 2);
+    uint32_t y0 = std::min(uint32_t(y), size - 2);
+    float fx = x - float(x0);
+    float fy = y - float(y0);
+    float top = glm::mix(getHeight(x0, y0), getHeight(x0 + 1, y0), fx);
+    float bottom = glm::mix(getHeight(x0, y0 + 1), getHeight(x0 + 1, y0 + 1), fx);
+    return glm::mix(top, bottom, fy);
+}
+
+glm::vec3 Heightmap::getNormal(uint32_t x, uint32_t y, float heightScale, float texelSize) const {
+    uint32_t left = x > 0 ? x - 1 : x;
+    uint32_t right = std::min(x + 1, size - 1);
+    uint32_t up = y > 0 ? y - 1 : y;
+    uint32_t down = std::min(y + 1, size - 1);
+    float dx = (getHeight(right, y) - getHeight(left, y)) * heightScale / (float(right - left) * texelSize);
+    float dz = (getHeight(x, down) - getHeight(x, up)) * heightScale / (float(down - up) * texelSize);
+    return glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+}
+
+std::vector<uint8_t> Heightmap::packTexels(float heightScale, float texelSize) const {
+    std::vector<uint8_t> texels(size_t(size) * size * 4);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            size_t index = size_t(y) * size + x;
+            glm::vec3 normal = getNormal(x, y, heightScale, texelSize);
+            texels[index * 4] = uint8_t(heights[index] >> 8);
+            texels[index * 4 + 1] = uint8_t(heights[index] & 0xff);
+            texels[index * 4 + 2] = uint8_t(std::lround((normal.x * 0.5f + 0.5f) * 255.0f));
+            texels[index * 4 + 3] = uint8_t(std::lround((normal.z * 0.5f + 0.5f) * 255.0f));
+        }
+    }
+    return texels;
+}
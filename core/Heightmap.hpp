@@ -0,0 +1,42 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_HEIGHTMAP_HPP
+#define VULKAN_EXPERIMENTS_HEIGHTMAP_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Square grid of 16-bit heights normalized to [0, 1], sampled on the CPU and uploaded as a texture for the GPU
+class Heightmap {
+public:
+    Heightmap() = default;
+    Heightmap(uint32_t size, std::vector<uint16_t> heights);
+
+    // fractal value noise, every octave doubles the frequency and halves the amplitude of the previous one. The map
+    // tiles, its last row and column continue into the first ones
+    static Heightmap generate(uint32_t size, uint32_t seed, uint32_t octaves = 6);
+    // half the size, every texel the average of four, for maps that tile
+    Heightmap downsample() const;
+
+    uint32_t getSize() const { return size; }
+    const uint16_t *getData() const { return heights.data(); }
+    float getHeight(uint32_t x, uint32_t y) const { return heights[size_t(y) * size + x] * (1.0f / 65535.0f); }
+    // bilinear between the four texels around uv, which is clamped to [0, 1]
+    float sample(float u, float v) const;
+    // normal of the surface scaled to heightScale over texels texelSize apart, from central differences
+    glm::vec3 getNormal(uint32_t x, uint32_t y, float heightScale, float texelSize) const;
+
+    // RGBA8 texels for the shaders: the height as high and low byte in red and green, the normal's x and z in blue and
+    // alpha. Filtering the split bytes would mix them, shaders fetch the four texels and interpolate themselves
+    std::vector<uint8_t> packTexels(float heightScale, float texelSize) const;
+
+private:
+    uint32_t size = 0;
+    std::vector<uint16_t> heights;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_HEIGHTMAP_HPP
@@ -0,0 +1,37 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MAPPEDFILE_HPP
+#define VULKAN_EXPERIMENTS_MAPPEDFILE_HPP
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    bool isOpen() const { return mappedData != nullptr; }
+    const char *data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+
+private:
+    const char *mappedData = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MAPPEDFILE_HPP
@@ -0,0 +1,161 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <cstring>
+#include <iostream>
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjLoader.hpp"
+
+namespace {
+
+// a coarser lod is only taken once its error is this far below the limit, the finer one is taken back at the limit
+constexpr float lodHysteresis = 0.75f;
+// simplification stops before the surface moves further than this fraction of the bounds diagonal
+constexpr float maxLodError = 0.02f;
+
+}
+
+bool Mesh::loadFromObj(const char *path, const MeshImportOptions &options) {
+    uint64_t sourceHash = MeshCache::hashSource(path);
+    std::string cachePath = MeshCache::getCachePath(path);
+    if (MeshCache::load(cachePath.c_str(), sourceHash, options.getFlags(), *this)) {
+        return true;
+    }
+    if (!importObj(path)) {
+        return false;
+    }
+    if (options.optimizeVertexCache) {
+        optimizeVertexCache();
+    }
+    if (options.optimizeOverdraw) {
+        optimizeOverdraw(options.overdrawThreshold);
+    }
+    // meshlets reorder the triangles once more, vertex fetch order follows whatever order is final
+    if (options.buildMeshlets) {
+        buildMeshlets();
+    }
+    // lods are appended behind the meshlet ordered full mesh and share its vertices
+    if (options.maxLods > 1) {
+        generateLods(options.maxLods);
+    }
+    if (options.optimizeVertexCache || options.optimizeOverdraw || options.buildMeshlets || options.maxLods > 1) {
+        optimizeVertexFetch();
+    }
+    computeBounds();
+    vertexLayout = options.vertexLayout == VertexLayout::COMPACT ? chooseCompactVertexLayout(vertices) : options.vertexLayout;
+    positionStream = options.positionStream;
+    MeshCompression compression = options.compressCache ? MeshCompression::MESH_CODEC : MeshCompression::NONE;
+    if (!MeshCache::write(cachePath.c_str(), *this, sourceHash, options.getFlags(), compression)) {
+        std::cout << "Failed to write mesh cache " << cachePath << std::endl;
+    }
+    return true;
+}
+
+bool Mesh::importObj(const char *path) {
+    ObjData obj;
+    if (!ObjLoader::load(path, obj)) {
+        return false;
+    }
+
+    // identical face corners collapse into one vertex, the index list references it
+    std::unordered_map<Vertex, uint32_t> uniqueVertices;
+    uniqueVertices.reserve(obj.positions.size() * 2);
+    vertices.reserve(obj.positions.size() * 2);
+    indices.reserve(obj.corners.size());
+
+    for (const auto& index : obj.corners) {
+        Vertex vertex{};
+        vertex.position = obj.positions[index.position];
+        if (index.normal >= 0) {
+            vertex.normal = obj.normals[index.normal];
+        }
+        if (index.texcoord >= 0) {
+            vertex.uv = obj.texcoords[index.texcoord];
+        }
+        vertex.color = {1.0f, 1.0f, 1.0f};
+
+        auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+        if (inserted) {
+            vertices.push_back(vertex);
+        }
+        indices.push_back(it->second);
+    }
+    return true;
+}
+
+void Mesh::computeBounds() {
+    bounds = ::computeBounds(vertices.data(), nullptr, vertices.size());
+    boundingSphere = computeBoundingSphere(vertices.data(), nullptr, vertices.size(), bounds);
+}
+
+void Mesh::optimizeVertexCache() {
+    auto before = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    MeshOptimizer::optimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    auto after = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    std::cout << "Vertex cache optimization: ACMR " << before.acmr << " -> " << after.acmr
+              << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
+
+void Mesh::optimizeOverdraw(float threshold) {
+    auto before = MeshOptimizer::analyzeOverdraw(indices, vertices);
+    auto cacheBefore = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    MeshOptimizer::optimizeOverdraw(indices, vertices, threshold);
+    auto after = MeshOptimizer::analyzeOverdraw(indices, vertices);
+    auto cacheAfter = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    std::cout << "Overdraw optimization: overdraw " << before.overdraw << " -> " << after.overdraw
+              << ", ACMR " << cacheBefore.acmr << " -> " << cacheAfter.acmr << std::endl;
+}
+
+void Mesh::optimizeVertexFetch() {
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+}
+
+void Mesh::buildMeshlets() {
+    auto before = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    meshlets = MeshletBuilder::build(indices, vertices);
+    auto after = MeshOptimizer::analyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+    uint32_t coneCount = 0;
+    float radius = 0.0f;
+    for (const auto &meshlet : meshlets) {
+        coneCount += meshlet.coneCutoff < 1.0f;
+        radius += meshlet.radius;
+    }
+    std::cout << "Built " << meshlets.size() << " meshlets, " << coneCount << " with a normal cone, average radius "
+              << (meshlets.empty() ? 0.0f : radius / meshlets.size()) << ", ACMR " << before.acmr << " -> " << after.acmr << std::endl;
+}
+
+void Mesh::generateLods(uint32_t maxLods) {
+    computeBounds();
+    lods = MeshSimplifier::buildLods(indices, vertices, maxLods, glm::length(bounds.max - bounds.min) * maxLodError);
+    std::cout << "Generated " << lods.size() << " lods:";
+    for (const auto &lod : lods) {
+        std::cout << " " << lod.indexCount / 3 << " triangles (error " << lod.error << ")";
+    }
+    std::cout << std::endl;
+}
+
+uint32_t Mesh::selectLod(const BoundingSphere &worldSphere, const glm::vec3 &cameraPosition, float projectionScale, float maxPixelError, uint32_t currentLod) const {
+    uint32_t lodCount = getLodCount();
+    if (lodCount <= 1) {
+        return 0;
+    }
+    const MeshLod *meshLods = getLods();
+    // the error is projected from the nearest point of the bounding sphere, inside of it only the full mesh is safe
+    float distance = glm::length(worldSphere.center - cameraPosition) - worldSphere.radius;
+    if (distance <= 0.0f || boundingSphere.radius <= 0.0f) {
+        return 0;
+    }
+    float scale = worldSphere.radius / boundingSphere.radius;
+    float pixelsPerUnit = scale * projectionScale / distance;
+    uint32_t lod = std::min(currentLod, lodCount - 1);
+    while (lod > 0 && meshLods[lod].error * pixelsPerUnit > maxPixelError) {
+        lod--;
+    }
+    while (lod + 1 < lodCount && meshLods[lod + 1].error * pixelsPerUnit <= maxPixelError * lodHysteresis) {
+        lod++;
+    }
+    return lod;
+}
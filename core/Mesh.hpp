@@ -5,10 +5,18 @@
 #ifndef VULKAN_EXPERIMENTS_MESH_HPP
 #define VULKAN_EXPERIMENTS_MESH_HPP
 
+#include <algorithm>
 #include <vector>
+#include <limits>
+#include <memory>
+#include <unordered_map>
 #include "glm/glm.hpp"
-#include "tiny_obj_loader.h"
+#include "MappedFile.hpp"
 #include "Shader.hpp"
+#include "Bounds.hpp"
+#include "VertexLayout.hpp"
+#include "Meshlet.hpp"
+#include "MeshSimplifier.hpp"
 
 struct Vertex {
     glm::vec3 position;
@@ -25,52 +33,149 @@ struct Vertex {
     }
 };
 
-struct Mesh {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-    glm::mat4 model = glm::mat4(1.0f);
+namespace std {
+template<>
+struct hash<Vertex> {
+    static void hashCombine(size_t &seed, float value) {
+        // +0.0f folds -0.0f into 0.0f so that equal vertices always hash equally
+        seed ^= std::hash<float>{}(value + 0.0f) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    size_t operator()(const Vertex &vertex) const noexcept {
+        size_t seed = 0;
+        for (int i = 0; i < 3; i++) hashCombine(seed, vertex.position[i]);
+        for (int i = 0; i < 3; i++) hashCombine(seed, vertex.normal[i]);
+        for (int i = 0; i < 3; i++) hashCombine(seed, vertex.color[i]);
+        for (int i = 0; i < 2; i++) hashCombine(seed, vertex.uv[i]);
+        return seed;
+    }
+};
+}
 
-    // load obj file
-    bool loadFromObj(const char *path) {
+// Raw vertex and index bytes laid out exactly as the GPU buffers expect them, or MeshCodec encoded when compressed is set
+struct MeshStreams {
+    // the data sizes are the encoded ones then, the counts and strides give the decoded size
+    bool compressed = false;
+    const void *vertexData = nullptr;
+    size_t vertexDataSize = 0;
+    uint32_t vertexCount = 0;
+    const void *indexData = nullptr;
+    size_t indexDataSize = 0;
+    uint32_t indexCount = 0;
+    uint32_t indexSize = sizeof(uint32_t);
+    // de-interleaved positions for depth only passes, null when the mesh was cooked without them or compressed, which
+    // rebuilds them from the vertices
+    const void *positionData = nullptr;
+    size_t positionDataSize = 0;
+    const Meshlet *meshletData = nullptr;
+    uint32_t meshletCount = 0;
+    const MeshLod *lodData = nullptr;
+    uint32_t lodCount = 0;
+};
 
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+// Processing stages run once at import, their result is stored in the mesh cache
+struct MeshImportOptions {
+    bool optimizeVertexCache = true;
+    // cluster sort for opaque meshes, applied on top of the vertex cache order
+    bool optimizeOverdraw = true;
+    // allowed ACMR growth of the overdraw clusters, 1.05 keeps them within 5% of the cache optimised order
+    float overdrawThreshold = 1.05f;
+    // layout of the stored vertex stream, COMPACT falls back to HALF when the uvs leave [0, 1]
+    VertexLayout vertexLayout = VertexLayout::STANDARD;
+    // keep a position-only copy of the vertices next to the interleaved stream
+    bool positionStream = false;
+    // split the optimised index buffer into meshlets for cluster culling
+    bool buildMeshlets = true;
+    // levels of detail including the full mesh, appended to the index buffer, 1 disables simplification
+    uint32_t maxLods = 5;
+    // store the vertex, position and index streams MeshCodec compressed, for slow disks and network file systems. Not
+    // part of the flags, a cache written either way is loaded
+    bool compressCache = true;
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path)) {
-            return false;
+    uint32_t getFlags() const {
+        uint32_t flags = optimizeVertexCache ? 1u : 0u;
+        if (positionStream) {
+            flags |= 4u;
         }
+        if (buildMeshlets) {
+            flags |= 8u;
+        }
+        flags |= static_cast<uint32_t>(vertexLayout) << 4;
+        if (optimizeOverdraw) {
+            flags |= 2u | (static_cast<uint32_t>(overdrawThreshold * 100.0f + 0.5f) << 8);
+        }
+        flags |= std::min(maxLods, 15u) << 24;
+        return flags;
+    }
+};
 
-        //vertices.resize(attrib.vertices.size() / 3);
-        for (const auto& shape : shapes) {
-            for (const auto& index : shape.mesh.indices) {
-                Vertex vertex{};
+struct Mesh {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    glm::mat4 model = glm::mat4(1.0f);
 
-                vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
-                };
+    Bounds bounds;
+    BoundingSphere boundingSphere;
+    // layout the vertex stream is encoded in on the GPU and in the cache, vertices always hold full floats
+    VertexLayout vertexLayout = VertexLayout::STANDARD;
+    // uploaded with a separate position-only stream that depth passes bind instead of the full vertices
+    bool positionStream = false;
+    // ranges of the index buffer with culling bounds, empty when the mesh was imported without them
+    std::vector<Meshlet> meshlets;
+    // the first lod is the full mesh, meshlets only cover that one
+    std::vector<MeshLod> lods;
 
-                vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                };
+    // A cooked mesh keeps its GPU ready streams in the mapped cache file, vertices and indices stay empty
+    std::shared_ptr<MappedFile> cookedFile;
+    MeshStreams cookedStreams;
 
-                vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1] };
+    // load obj file, going through the binary mesh cache next to it
+    bool loadFromObj(const char *path, const MeshImportOptions &options = {});
+    // parse the obj file and build the indexed vertex list
+    bool importObj(const char *path);
+    // box and sphere of the vertices in object space
+    void computeBounds();
+    // reorder triangles for the post-transform cache
+    void optimizeVertexCache();
+    // sort triangle clusters to reduce overdraw, keeping ACMR within threshold
+    void optimizeOverdraw(float threshold);
+    // renumber vertices by first use
+    void optimizeVertexFetch();
+    void buildMeshlets();
+    void generateLods(uint32_t maxLods);
+    // coarsest lod whose error stays within maxPixelError on screen, worldSphere is the bounding sphere moved by the
+    // instance's model and projectionScale the projection's y scale times half the viewport height, the current lod
+    // is kept while its error is only slightly off to avoid flicker
+    uint32_t selectLod(const BoundingSphere &worldSphere, const glm::vec3 &cameraPosition, float projectionScale, float maxPixelError, uint32_t currentLod) const;
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+    // quantized layouts store positions relative to the bounds, the model matrix has to be multiplied by this
+    glm::mat4 getDequantizationTransform() const { return ::getDequantizationTransform(vertexLayout, bounds); }
+    uint32_t getVertexStride() const { return ::getVertexStride(vertexLayout); }
+    uint32_t getPositionStride() const { return ::getPositionStride(vertexLayout); }
 
-                //vertices[index.vertex_index] = vertex;
-                vertices.push_back(vertex);
-                //indices.push_back(index.vertex_index);
-            }
-        }
-        return true;
+    bool isCooked() const { return cookedFile != nullptr; }
+    uint32_t getVertexCount() const {
+        return isCooked() ? cookedStreams.vertexCount : static_cast<uint32_t>(vertices.size());
+    }
+    uint32_t getIndexCount() const {
+        return isCooked() ? cookedStreams.indexCount : static_cast<uint32_t>(indices.size());
+    }
+    const Meshlet *getMeshlets() const {
+        return isCooked() ? cookedStreams.meshletData : meshlets.data();
+    }
+    uint32_t getMeshletCount() const {
+        return isCooked() ? cookedStreams.meshletCount : static_cast<uint32_t>(meshlets.size());
+    }
+    const MeshLod *getLods() const {
+        return isCooked() ? cookedStreams.lodData : lods.data();
+    }
+    uint32_t getLodCount() const {
+        return isCooked() ? cookedStreams.lodCount : static_cast<uint32_t>(lods.size());
+    }
+
+    // 16-bit indices are enough when every vertex can be addressed by them
+    bool hasShortIndices() const {
+        return getVertexCount() <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1;
     }
 
     // Generate a terrain quad patch for feeding to the tessellation control shader with given size
@@ -110,6 +215,62 @@ struct Mesh {
         }
         return mesh;
     }
+
+    // Generate a grid of gridSize x gridSize quads over [0, 1] in x and z for chunked lod terrain nodes. gridSize has to
+    // be even, the triangles are ordered by quadrant so that each quarter of the grid is a quarter of the index range
+    static Mesh generateTerrainGrid(uint32_t gridSize) {
+        Mesh mesh{};
+        const uint32_t rowSize = gridSize + 1;
+        mesh.vertices.resize(rowSize * rowSize);
+        for (uint32_t y = 0; y < rowSize; y++) {
+            for (uint32_t x = 0; x < rowSize; x++) {
+                glm::vec2 position = glm::vec2((float)x, (float)y) / (float)gridSize;
+                auto &vertex = mesh.vertices[x + y * rowSize];
+                vertex.position = {position.x, 0.0f, position.y};
+                vertex.normal = {0.0f, 1.0f, 0.0f};
+                vertex.color = {1.0f, 1.0f, 1.0f};
+                vertex.uv = position;
+            }
+        }
+
+        const uint32_t half = gridSize / 2;
+        mesh.indices.reserve(gridSize * gridSize * 6);
+        for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+            uint32_t startX = (quadrant % 2) * half;
+            uint32_t startY = (quadrant / 2) * half;
+            for (uint32_t y = startY; y < startY + half; y++) {
+                for (uint32_t x = startX; x < startX + half; x++) {
+                    uint32_t index = x + y * rowSize;
+                    mesh.indices.insert(mesh.indices.end(), {index, index + rowSize, index + 1, index + 1, index + rowSize, index + rowSize + 1});
+                }
+            }
+        }
+        return mesh;
+    }
+
+    // Generate a grid of width x height quads of unit size in x and z, the blocks geometry clipmap rings are built of
+    static Mesh generateTerrainBlock(uint32_t width, uint32_t height) {
+        Mesh mesh{};
+        const uint32_t rowSize = width + 1;
+        mesh.vertices.resize(rowSize * (height + 1));
+        for (uint32_t y = 0; y <= height; y++) {
+            for (uint32_t x = 0; x < rowSize; x++) {
+                auto &vertex = mesh.vertices[x + y * rowSize];
+                vertex.position = {(float)x, 0.0f, (float)y};
+                vertex.normal = {0.0f, 1.0f, 0.0f};
+                vertex.color = {1.0f, 1.0f, 1.0f};
+                vertex.uv = glm::vec2((float)x / width, (float)y / height);
+            }
+        }
+        mesh.indices.reserve(width * height * 6);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t index = x + y * rowSize;
+                mesh.indices.insert(mesh.indices.end(), {index, index + rowSize, index + 1, index + 1, index + rowSize, index + rowSize + 1});
+            }
+        }
+        return mesh;
+    }
 };
 
 struct RenderObject {
@@ -0,0 +1,209 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "MeshCache.hpp"
+#include "MeshCodec.hpp"
+
+namespace {
+
+constexpr uint64_t streamAlignment = 16;
+
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + streamAlignment - 1) & ~(streamAlignment - 1);
+}
+
+uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void writePadding(std::ofstream &file, uint64_t offset) {
+    while (static_cast<uint64_t>(file.tellp()) < offset) {
+        file.put(0);
+    }
+}
+
+}
+
+std::string MeshCache::getCachePath(const char *sourcePath) {
+    return std::string(sourcePath) + ".meshcache";
+}
+
+uint64_t MeshCache::hashSource(const char *sourcePath) {
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(sourcePath, error);
+    if (error) {
+        return 0;
+    }
+    auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error) {
+        return 0;
+    }
+    int64_t ticks = writeTime.time_since_epoch().count();
+    uint64_t hash = fnv1a(14695981039346656037ull, &size, sizeof(size));
+    return fnv1a(hash, &ticks, sizeof(ticks));
+}
+
+bool MeshCache::write(const char *path, const Mesh &mesh, uint64_t sourceHash, uint32_t importFlags, MeshCompression compression) {
+    if (sourceHash == 0 || mesh.isCooked()) {
+        return false;
+    }
+    MeshCacheHeader header;
+    header.sourceHash = sourceHash;
+    header.importFlags = importFlags;
+    header.vertexCount = mesh.getVertexCount();
+    header.vertexLayout = static_cast<uint32_t>(mesh.vertexLayout);
+    header.vertexStride = mesh.getVertexStride();
+    header.indexCount = mesh.getIndexCount();
+    header.indexSize = mesh.hasShortIndices() ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.compression = static_cast<uint32_t>(compression);
+    memcpy(header.boundsMin, &mesh.bounds.min, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, &mesh.bounds.max, sizeof(header.boundsMax));
+    memcpy(header.sphereCenter, &mesh.boundingSphere.center, sizeof(header.sphereCenter));
+    header.sphereRadius = mesh.boundingSphere.radius;
+
+    std::vector<uint8_t> vertexData(size_t(header.vertexCount) * header.vertexStride);
+    encodeVertices(mesh.vertexLayout, mesh.vertices, mesh.bounds, vertexData.data());
+    std::vector<uint8_t> indexData(size_t(header.indexCount) * header.indexSize);
+    if (header.indexSize == sizeof(uint16_t)) {
+        std::copy(mesh.indices.begin(), mesh.indices.end(), reinterpret_cast<uint16_t *>(indexData.data()));
+    }
+    else {
+        memcpy(indexData.data(), mesh.indices.data(), indexData.size());
+    }
+    // the positions are the start of every vertex, a compressed cache rebuilds them from the decoded vertices
+    std::vector<uint8_t> positionData;
+    if (mesh.positionStream) {
+        header.positionStride = mesh.getPositionStride();
+    }
+    if (mesh.positionStream && compression == MeshCompression::NONE) {
+        positionData.resize(size_t(header.vertexCount) * header.positionStride);
+        encodePositions(mesh.vertexLayout, mesh.vertices, mesh.bounds, positionData.data());
+    }
+    if (compression == MeshCompression::MESH_CODEC) {
+        vertexData = MeshCodec::encodeVertices(vertexData.data(), header.vertexCount, header.vertexStride);
+        indexData = MeshCodec::encodeIndices(mesh.indices.data(), mesh.indices.size());
+    }
+    header.vertexDataSize = vertexData.size();
+    header.indexDataSize = indexData.size();
+    header.positionDataSize = positionData.size();
+    header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + header.vertexDataSize);
+    header.positionOffset = positionData.empty() ? 0 : alignOffset(header.indexOffset + header.indexDataSize);
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.meshletOffset = alignOffset(std::max(header.indexOffset + header.indexDataSize, header.positionOffset + header.positionDataSize));
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.lodOffset = alignOffset(header.meshletOffset + uint64_t(header.meshletCount) * sizeof(Meshlet));
+
+    // written aside and renamed so that an interrupted write never leaves a truncated cache behind
+    std::string tempPath = std::string(path) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        writePadding(file, header.vertexOffset);
+        file.write(reinterpret_cast<const char *>(vertexData.data()), std::streamsize(vertexData.size()));
+        writePadding(file, header.indexOffset);
+        file.write(reinterpret_cast<const char *>(indexData.data()), std::streamsize(indexData.size()));
+        if (!positionData.empty()) {
+            writePadding(file, header.positionOffset);
+            file.write(reinterpret_cast<const char *>(positionData.data()), std::streamsize(positionData.size()));
+        }
+        writePadding(file, header.meshletOffset);
+        file.write(reinterpret_cast<const char *>(mesh.meshlets.data()), std::streamsize(mesh.meshlets.size() * sizeof(Meshlet)));
+        writePadding(file, header.lodOffset);
+        file.write(reinterpret_cast<const char *>(mesh.lods.data()), std::streamsize(mesh.lods.size() * sizeof(MeshLod)));
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool MeshCache::load(const char *path, uint64_t sourceHash, uint32_t importFlags, Mesh &mesh) {
+    if (sourceHash == 0) {
+        return false;
+    }
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+    MeshCacheHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != MeshCacheHeader::MAGIC || header.version != MeshCacheHeader::VERSION ||
+        header.sourceHash != sourceHash || header.importFlags != importFlags || header.vertexLayout > static_cast<uint32_t>(VertexLayout::COMPACT) ||
+        header.vertexStride != getVertexStride(static_cast<VertexLayout>(header.vertexLayout)) ||
+        header.compression > static_cast<uint32_t>(MeshCompression::MESH_CODEC)) {
+        return false;
+    }
+    bool compressed = header.compression == static_cast<uint32_t>(MeshCompression::MESH_CODEC);
+    uint64_t vertexDataSize = header.vertexDataSize;
+    uint64_t indexDataSize = header.indexDataSize;
+    uint64_t positionDataSize = header.positionDataSize;
+    // the decoder checks the encoded streams against the counts on upload, the raw ones have to match them here
+    if (!compressed && (vertexDataSize != uint64_t(header.vertexCount) * header.vertexStride || indexDataSize != uint64_t(header.indexCount) * header.indexSize ||
+                        positionDataSize != uint64_t(header.vertexCount) * header.positionStride)) {
+        return false;
+    }
+    if (compressed && positionDataSize != 0) {
+        return false;
+    }
+    uint64_t meshletDataSize = uint64_t(header.meshletCount) * sizeof(Meshlet);
+    uint64_t lodDataSize = uint64_t(header.lodCount) * sizeof(MeshLod);
+    if (header.vertexOffset + vertexDataSize > file->size() || header.indexOffset + indexDataSize > file->size() ||
+        header.positionOffset + positionDataSize > file->size() || header.meshletOffset + meshletDataSize > file->size() ||
+        header.lodOffset + lodDataSize > file->size()) {
+        return false;
+    }
+    // lod ranges are read on every draw, one outside the index buffer would fault on the GPU
+    auto lods = reinterpret_cast<const MeshLod *>(file->data() + header.lodOffset);
+    for (uint32_t i = 0; i < header.lodCount; i++) {
+        if (uint64_t(lods[i].indexOffset) + lods[i].indexCount > header.indexCount) {
+            return false;
+        }
+    }
+    auto layout = static_cast<VertexLayout>(header.vertexLayout);
+    if (header.positionStride != 0 && header.positionStride != getPositionStride(layout)) {
+        return false;
+    }
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.meshlets.clear();
+    mesh.lods.clear();
+    memcpy(&mesh.bounds.min, header.boundsMin, sizeof(header.boundsMin));
+    memcpy(&mesh.bounds.max, header.boundsMax, sizeof(header.boundsMax));
+    memcpy(&mesh.boundingSphere.center, header.sphereCenter, sizeof(header.sphereCenter));
+    mesh.boundingSphere.radius = header.sphereRadius;
+    mesh.vertexLayout = layout;
+    mesh.positionStream = header.positionStride != 0;
+    mesh.cookedStreams.compressed = compressed;
+    mesh.cookedStreams.vertexData = file->data() + header.vertexOffset;
+    mesh.cookedStreams.vertexDataSize = vertexDataSize;
+    mesh.cookedStreams.vertexCount = header.vertexCount;
+    mesh.cookedStreams.indexData = file->data() + header.indexOffset;
+    mesh.cookedStreams.indexDataSize = indexDataSize;
+    mesh.cookedStreams.indexCount = header.indexCount;
+    mesh.cookedStreams.indexSize = header.indexSize;
+    mesh.cookedStreams.positionData = mesh.positionStream && !compressed ? file->data() + header.positionOffset : nullptr;
+    mesh.cookedStreams.positionDataSize = positionDataSize;
+    // 16-byte aligned in the mapping, the meshlets are used in place
+    mesh.cookedStreams.meshletData = reinterpret_cast<const Meshlet *>(file->data() + header.meshletOffset);
+    mesh.cookedStreams.meshletCount = header.meshletCount;
+    mesh.cookedStreams.lodData = header.lodCount > 0 ? lods : nullptr;
+    mesh.cookedStreams.lodCount = header.lodCount;
+    mesh.cookedFile = std::move(file);
+    return true;
+}
@@ -0,0 +1,68 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MESHCACHE_HPP
+#define VULKAN_EXPERIMENTS_MESHCACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include "Mesh.hpp"
+
+enum class MeshCompression : uint32_t {
+    // streams are stored as the GPU reads them and are copied from the mapping
+    NONE = 0,
+    // vertex and index streams are MeshCodec encoded and decoded into the staging buffer, the position stream is not
+    // stored and is taken from the decoded vertices
+    MESH_CODEC,
+};
+
+// On-disk layout of a cooked mesh, the streams follow the header at the given offsets
+struct MeshCacheHeader {
+    static constexpr uint32_t MAGIC = 0x484D5856; // "VXMH"
+    static constexpr uint32_t VERSION = 9;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint64_t sourceHash = 0;
+    // MeshImportOptions flags the streams were processed with
+    uint32_t importFlags = 0;
+    uint32_t vertexCount = 0;
+    uint32_t vertexLayout = 0;
+    uint32_t vertexStride = 0;
+    uint32_t indexCount = 0;
+    uint32_t indexSize = 0;
+    // 0 when there is no position-only stream, which is only stored uncompressed
+    uint32_t positionStride = 0;
+    uint32_t meshletCount = 0;
+    uint32_t lodCount = 0;
+    uint32_t compression = static_cast<uint32_t>(MeshCompression::NONE);
+    float boundsMin[3] = {};
+    float boundsMax[3] = {};
+    float sphereCenter[3] = {};
+    float sphereRadius = 0.0f;
+    uint64_t vertexOffset = 0;
+    uint64_t indexOffset = 0;
+    uint64_t positionOffset = 0;
+    uint64_t meshletOffset = 0;
+    uint64_t lodOffset = 0;
+    // bytes of the streams in the file, smaller than their GPU size when they are compressed
+    uint64_t vertexDataSize = 0;
+    uint64_t indexDataSize = 0;
+    uint64_t positionDataSize = 0;
+};
+
+// Binary mesh container written next to the source after the first import and memory-mapped afterwards
+class MeshCache {
+public:
+    static std::string getCachePath(const char *sourcePath);
+    // cheap fingerprint of the source file from its size and modification time
+    static uint64_t hashSource(const char *sourcePath);
+    static bool write(const char *path, const Mesh &mesh, uint64_t sourceHash, uint32_t importFlags, MeshCompression compression);
+    // maps the cache into mesh, fails when it is missing, stale, from another version or imported with other options.
+    // Either compression is loaded
+    static bool load(const char *path, uint64_t sourceHash, uint32_t importFlags, Mesh &mesh);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MESHCACHE_HPP
@@ -0,0 +1,492 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "MeshCodec.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CODEC_USE_SSE
+#endif
+
+namespace {
+
+// vertices are coded in blocks so that the decoded columns of one block stay in the L1 cache until they are interleaved
+const size_t BLOCK_VERTICES = 256;
+const size_t GROUP_SIZE = 16;
+const size_t MAX_STRIDE = 256;
+// packed bytes of a group for each 2-bit header code
+const size_t GROUP_BYTES[4] = {0, 4, 8, 16};
+
+const uint32_t FIFO_SIZE = 16;
+// a triangle that shares no edge with the edge FIFO, its vertices follow one by one
+const uint8_t CODE_NO_EDGE = 15;
+// low nibble of a triangle with a shared edge, the third vertex is given explicitly
+const uint8_t CODE_EXPLICIT_VERTEX = 15;
+// vertex references of triangles without a shared edge, larger ones are zigzagged deltas to the last explicit vertex
+const uint32_t REFERENCE_NEXT = 0;
+const uint32_t REFERENCE_EXPLICIT = 1 + FIFO_SIZE;
+
+inline uint8_t encodeZigzag(uint8_t delta) {
+    return uint8_t((delta << 1) ^ uint8_t(int8_t(delta) >> 7));
+}
+
+inline uint8_t decodeZigzag(uint8_t value) {
+    return uint8_t((value >> 1) ^ -(value & 1));
+}
+
+inline uint32_t encodeZigzag(int32_t delta) {
+    return (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+}
+
+inline int32_t decodeZigzag(uint32_t value) {
+    return int32_t((value >> 1) ^ -(value & 1));
+}
+
+size_t getGroupCode(const uint8_t *values) {
+    uint8_t maxValue = *std::max_element(values, values + GROUP_SIZE);
+    return maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+}
+
+void packGroup(size_t code, const uint8_t *values, std::vector<uint8_t> &data) {
+    size_t start = data.size();
+    data.resize(start + GROUP_BYTES[code], 0);
+    uint8_t *packed = data.data() + start;
+    for (size_t i = 0; i < GROUP_SIZE && code != 0; i++) {
+        switch (code) {
+            case 1:
+                packed[i / 4] |= uint8_t(values[i] << (2 * (i % 4)));
+                break;
+            case 2:
+                packed[i / 2] |= uint8_t(values[i] << (4 * (i % 2)));
+                break;
+            default:
+                packed[i] = values[i];
+                break;
+        }
+    }
+}
+
+#ifdef CODEC_USE_SSE
+
+inline __m128i unpackGroup(size_t code, const uint8_t *packed) {
+    switch (code) {
+        case 0:
+            return _mm_setzero_si128();
+        case 1: {
+            // four values per byte, every shifted copy picks one of them and the unpacks interleave them back in order
+            int32_t bytes;
+            memcpy(&bytes, packed, sizeof(bytes));
+            __m128i word = _mm_cvtsi32_si128(bytes);
+            __m128i mask = _mm_set1_epi8(3);
+            __m128i first = _mm_and_si128(word, mask);
+            __m128i second = _mm_and_si128(_mm_srli_epi16(word, 2), mask);
+            __m128i third = _mm_and_si128(_mm_srli_epi16(word, 4), mask);
+            __m128i fourth = _mm_and_si128(_mm_srli_epi16(word, 6), mask);
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(first, second), _mm_unpacklo_epi8(third, fourth));
+        }
+        case 2: {
+            __m128i word = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(packed));
+            __m128i mask = _mm_set1_epi8(15);
+            return _mm_unpacklo_epi8(_mm_and_si128(word, mask), _mm_and_si128(_mm_srli_epi16(word, 4), mask));
+        }
+        default:
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed));
+    }
+}
+
+// undoes the zigzag and adds up the deltas of a group starting from base, returns the last value
+inline uint8_t decodeGroup(size_t code, const uint8_t *packed, uint8_t base, uint8_t *column) {
+    __m128i values = unpackGroup(code, packed);
+    __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(values, _mm_set1_epi8(1)));
+    values = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(values, 1), _mm_set1_epi8(0x7f)), sign);
+    // prefix sum over the 16 lanes in four shifted adds
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 1));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 2));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 4));
+    values = _mm_add_epi8(values, _mm_slli_si128(values, 8));
+    values = _mm_add_epi8(values, _mm_set1_epi8(char(base)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(column), values);
+    return uint8_t(_mm_cvtsi128_si32(_mm_srli_si128(values, 15)));
+}
+
+// four decoded columns of 16 vertices transposed into 4 bytes of each vertex
+inline void interleaveColumns(const uint8_t *columns, size_t first, size_t count, size_t byte, size_t stride, uint8_t *destination) {
+    for (size_t vertex = 0; vertex < count; vertex += GROUP_SIZE) {
+        __m128i column0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns + byte * BLOCK_VERTICES + vertex));
+        __m128i column1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns + (byte + 1) * BLOCK_VERTICES + vertex));
+        __m128i column2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns + (byte + 2) * BLOCK_VERTICES + vertex));
+        __m128i column3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(columns + (byte + 3) * BLOCK_VERTICES + vertex));
+        __m128i low01 = _mm_unpacklo_epi8(column0, column1);
+        __m128i high01 = _mm_unpackhi_epi8(column0, column1);
+        __m128i low23 = _mm_unpacklo_epi8(column2, column3);
+        __m128i high23 = _mm_unpackhi_epi8(column2, column3);
+        __m128i words[4] = {_mm_unpacklo_epi16(low01, low23), _mm_unpackhi_epi16(low01, low23),
+                            _mm_unpacklo_epi16(high01, high23), _mm_unpackhi_epi16(high01, high23)};
+        size_t groupCount = std::min(GROUP_SIZE, count - vertex);
+        uint8_t *target = destination + (first + vertex) * stride + byte;
+        for (size_t i = 0; i < groupCount; i++) {
+            int32_t word = _mm_cvtsi128_si32(words[i / 4]);
+            words[i / 4] = _mm_srli_si128(words[i / 4], 4);
+            memcpy(target + i * stride, &word, sizeof(word));
+        }
+    }
+}
+
+#else
+
+inline uint8_t decodeGroup(size_t code, const uint8_t *packed, uint8_t base, uint8_t *column) {
+    for (size_t i = 0; i < GROUP_SIZE; i++) {
+        uint8_t value = 0;
+        switch (code) {
+            case 1:
+                value = (packed[i / 4] >> (2 * (i % 4))) & 3;
+                break;
+            case 2:
+                value = (packed[i / 2] >> (4 * (i % 2))) & 15;
+                break;
+            case 3:
+                value = packed[i];
+                break;
+        }
+        base = uint8_t(base + decodeZigzag(value));
+        column[i] = base;
+    }
+    return base;
+}
+
+inline void interleaveColumns(const uint8_t *columns, size_t first, size_t count, size_t byte, size_t stride, uint8_t *destination) {
+    for (size_t vertex = 0; vertex < count; vertex++) {
+        for (size_t i = 0; i < 4; i++) {
+            destination[(first + vertex) * stride + byte + i] = columns[(byte + i) * BLOCK_VERTICES + vertex];
+        }
+    }
+}
+
+#endif
+
+void writeVarint(uint32_t value, std::vector<uint8_t> &data) {
+    while (value >= 0x80) {
+        data.push_back(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(uint8_t(value));
+}
+
+bool readVarint(const uint8_t *&data, const uint8_t *end, uint32_t &value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        if (data == end) {
+            return false;
+        }
+        uint8_t byte = *data++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// state the index encoder and decoder update the same way after every triangle
+struct IndexCoderState {
+    uint32_t edges[FIFO_SIZE][2];
+    uint32_t edgeCount = 0;
+    uint32_t vertices[FIFO_SIZE];
+    uint32_t vertexCount = 0;
+    // vertices are numbered by first use, so a new vertex is mostly the next one
+    uint32_t next = 0;
+    uint32_t last = 0;
+
+    IndexCoderState() {
+        std::fill(&edges[0][0], &edges[0][0] + FIFO_SIZE * 2, ~0u);
+        std::fill(vertices, vertices + FIFO_SIZE, ~0u);
+    }
+
+    // 0 is the most recent entry
+    const uint32_t *getEdge(uint32_t i) const { return edges[(edgeCount - 1 - i) % FIFO_SIZE]; }
+    uint32_t getVertex(uint32_t i) const { return vertices[(vertexCount - 1 - i) % FIFO_SIZE]; }
+
+    int32_t findEdge(uint32_t a, uint32_t b) const {
+        for (uint32_t i = 0; i < CODE_NO_EDGE; i++) {
+            const uint32_t *edge = getEdge(i);
+            if (edge[0] == a && edge[1] == b) {
+                return int32_t(i);
+            }
+        }
+        return -1;
+    }
+
+    int32_t findVertex(uint32_t vertex, uint32_t range) const {
+        for (uint32_t i = 0; i < range; i++) {
+            if (getVertex(i) == vertex) {
+                return int32_t(i);
+            }
+        }
+        return -1;
+    }
+
+    void pushEdge(uint32_t a, uint32_t b) {
+        edges[edgeCount % FIFO_SIZE][0] = a;
+        edges[edgeCount % FIFO_SIZE][1] = b;
+        edgeCount++;
+    }
+
+    void pushVertex(uint32_t vertex) {
+        vertices[vertexCount % FIFO_SIZE] = vertex;
+        vertexCount++;
+    }
+
+    // the triangle across each edge walks it the other way round, it is found by its first two vertices
+    void pushTriangleEdges(uint32_t a, uint32_t b, uint32_t c, bool sharedEdge) {
+        if (!sharedEdge) {
+            pushEdge(b, a);
+        }
+        pushEdge(c, b);
+        pushEdge(a, c);
+    }
+};
+
+// reference of a vertex of a triangle without a shared edge, updates state like decoding it does
+uint32_t encodeVertexReference(IndexCoderState &state, uint32_t vertex) {
+    if (vertex == state.next) {
+        state.next++;
+        state.pushVertex(vertex);
+        return REFERENCE_NEXT;
+    }
+    int32_t cached = state.findVertex(vertex, FIFO_SIZE);
+    if (cached >= 0) {
+        return 1 + uint32_t(cached);
+    }
+    uint32_t reference = REFERENCE_EXPLICIT + encodeZigzag(int32_t(vertex - state.last));
+    state.last = vertex;
+    state.pushVertex(vertex);
+    return reference;
+}
+
+bool decodeVertexReference(IndexCoderState &state, uint32_t reference, uint32_t &vertex) {
+    if (reference == REFERENCE_NEXT) {
+        vertex = state.next++;
+    }
+    else if (reference < REFERENCE_EXPLICIT) {
+        vertex = state.getVertex(reference - 1);
+        return vertex != ~0u;
+    }
+    else {
+        vertex = state.last + uint32_t(decodeZigzag(reference - REFERENCE_EXPLICIT));
+        state.last = vertex;
+    }
+    state.pushVertex(vertex);
+    return true;
+}
+
+template<typename Index>
+bool decodeTriangles(Index *indices, size_t count, uint32_t vertexCount, const uint8_t *data, const uint8_t *end) {
+    IndexCoderState state;
+    for (size_t i = 0; i < count; i += 3) {
+        if (data == end) {
+            return false;
+        }
+        uint8_t code = *data++;
+        uint32_t edgeCode = code >> 4;
+        uint32_t a, b, c;
+        if (edgeCode != CODE_NO_EDGE) {
+            const uint32_t *edge = state.getEdge(edgeCode);
+            a = edge[0];
+            b = edge[1];
+            uint32_t third = code & 15;
+            if (a == ~0u) {
+                return false;
+            }
+            if (third == 0) {
+                c = state.next++;
+                state.pushVertex(c);
+            }
+            else if (third != CODE_EXPLICIT_VERTEX) {
+                c = state.getVertex(third - 1);
+                if (c == ~0u) {
+                    return false;
+                }
+            }
+            else {
+                uint32_t delta;
+                if (!readVarint(data, end, delta)) {
+                    return false;
+                }
+                c = state.last + uint32_t(decodeZigzag(delta));
+                state.last = c;
+                state.pushVertex(c);
+            }
+        }
+        else {
+            uint32_t references[3];
+            if ((code & 15) != 0 || !readVarint(data, end, references[0]) || !decodeVertexReference(state, references[0], a) ||
+                !readVarint(data, end, references[1]) || !decodeVertexReference(state, references[1], b) ||
+                !readVarint(data, end, references[2]) || !decodeVertexReference(state, references[2], c)) {
+                return false;
+            }
+        }
+        // a corrupt or stale stream must not reach vertices past the end of the mesh
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) {
+            return false;
+        }
+        state.pushTriangleEdges(a, b, c, edgeCode != CODE_NO_EDGE);
+        indices[i] = Index(a);
+        indices[i + 1] = Index(b);
+        indices[i + 2] = Index(c);
+    }
+    return data == end;
+}
+
+}
+
+std::vector<uint8_t> MeshCodec::encodeVertices(const void *vertices, size_t count, size_t stride) {
+    if (stride % 4 != 0 || stride == 0 || stride > MAX_STRIDE) {
+        throw std::runtime_error("Vertex stride cannot be encoded");
+    }
+    auto bytes = static_cast<const uint8_t *>(vertices);
+    std::vector<uint8_t> data;
+    data.reserve(count * stride / 2);
+    std::vector<uint8_t> previous(stride, 0);
+    uint8_t deltas[BLOCK_VERTICES];
+    for (size_t first = 0; first < count; first += BLOCK_VERTICES) {
+        size_t blockCount = std::min(BLOCK_VERTICES, count - first);
+        size_t groupCount = (blockCount + GROUP_SIZE - 1) / GROUP_SIZE;
+        for (size_t byte = 0; byte < stride; byte++) {
+            // the groups are padded with zero deltas, which repeat the last vertex
+            std::fill(deltas, deltas + BLOCK_VERTICES, 0);
+            uint8_t last = previous[byte];
+            for (size_t i = 0; i < blockCount; i++) {
+                uint8_t value = bytes[(first + i) * stride + byte];
+                deltas[i] = encodeZigzag(uint8_t(value - last));
+                last = value;
+            }
+            previous[byte] = last;
+            size_t header = data.size();
+            data.resize(header + (groupCount + 3) / 4, 0);
+            for (size_t group = 0; group < groupCount; group++) {
+                size_t code = getGroupCode(deltas + group * GROUP_SIZE);
+                data[header + group / 4] |= uint8_t(code << (2 * (group % 4)));
+                packGroup(code, deltas + group * GROUP_SIZE, data);
+            }
+        }
+    }
+    return data;
+}
+
+bool MeshCodec::decodeVertices(void *destination, size_t count, size_t stride, const uint8_t *data, size_t size) {
+    if (stride % 4 != 0 || stride == 0 || stride > MAX_STRIDE) {
+        return false;
+    }
+    auto bytes = static_cast<uint8_t *>(destination);
+    const uint8_t *end = data + size;
+    // a column of every byte of the vertex in the block, with room for the padding of the last group
+    std::vector<uint8_t> columns(stride * BLOCK_VERTICES);
+    std::vector<uint8_t> previous(stride, 0);
+    for (size_t first = 0; first < count; first += BLOCK_VERTICES) {
+        size_t blockCount = std::min(BLOCK_VERTICES, count - first);
+        size_t groupCount = (blockCount + GROUP_SIZE - 1) / GROUP_SIZE;
+        for (size_t byte = 0; byte < stride; byte++) {
+            size_t headerSize = (groupCount + 3) / 4;
+            if (size_t(end - data) < headerSize) {
+                return false;
+            }
+            const uint8_t *header = data;
+            data += headerSize;
+            size_t packedSize = 0;
+            for (size_t group = 0; group < groupCount; group++) {
+                packedSize += GROUP_BYTES[(header[group / 4] >> (2 * (group % 4))) & 3];
+            }
+            if (size_t(end - data) < packedSize) {
+                return false;
+            }
+            uint8_t base = previous[byte];
+            uint8_t *column = columns.data() + byte * BLOCK_VERTICES;
+            for (size_t group = 0; group < groupCount; group++) {
+                size_t code = (header[group / 4] >> (2 * (group % 4))) & 3;
+                base = decodeGroup(code, data, base, column + group * GROUP_SIZE);
+                data += GROUP_BYTES[code];
+            }
+            previous[byte] = base;
+        }
+        for (size_t byte = 0; byte < stride; byte += 4) {
+            interleaveColumns(columns.data(), first, blockCount, byte, stride, bytes);
+        }
+    }
+    return data == end;
+}
+
+std::vector<uint8_t> MeshCodec::encodeIndices(const uint32_t *indices, size_t count) {
+    if (count % 3 != 0) {
+        throw std::runtime_error("Index count is not a multiple of 3");
+    }
+    std::vector<uint8_t> data;
+    data.reserve(count / 2);
+    IndexCoderState state;
+    for (size_t i = 0; i < count; i += 3) {
+        uint32_t triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        // the rotation that continues a recent edge with the cheapest third vertex: next, cached, then explicit
+        int32_t bestRotation = -1;
+        int32_t bestEdge = -1;
+        uint32_t bestCost = 3;
+        for (int32_t rotation = 0; rotation < 3; rotation++) {
+            uint32_t a = triangle[rotation];
+            uint32_t b = triangle[(rotation + 1) % 3];
+            uint32_t c = triangle[(rotation + 2) % 3];
+            int32_t edge = state.findEdge(a, b);
+            if (edge < 0) {
+                continue;
+            }
+            uint32_t cost = c == state.next ? 0 : state.findVertex(c, CODE_EXPLICIT_VERTEX - 1) >= 0 ? 1 : 2;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestRotation = rotation;
+                bestEdge = edge;
+            }
+        }
+        if (bestRotation < 0) {
+            data.push_back(uint8_t(CODE_NO_EDGE << 4));
+            for (uint32_t vertex : triangle) {
+                writeVarint(encodeVertexReference(state, vertex), data);
+            }
+            state.pushTriangleEdges(triangle[0], triangle[1], triangle[2], false);
+            continue;
+        }
+        uint32_t a = triangle[bestRotation];
+        uint32_t b = triangle[(bestRotation + 1) % 3];
+        uint32_t c = triangle[(bestRotation + 2) % 3];
+        uint8_t code = uint8_t(bestEdge << 4);
+        if (bestCost == 0) {
+            state.next++;
+            state.pushVertex(c);
+            data.push_back(code);
+        }
+        else if (bestCost == 1) {
+            data.push_back(uint8_t(code | (1 + state.findVertex(c, CODE_EXPLICIT_VERTEX - 1))));
+        }
+        else {
+            data.push_back(uint8_t(code | CODE_EXPLICIT_VERTEX));
+            writeVarint(encodeZigzag(int32_t(c - state.last)), data);
+            state.last = c;
+            state.pushVertex(c);
+        }
+        state.pushTriangleEdges(a, b, c, true);
+    }
+    return data;
+}
+
+bool MeshCodec::decodeIndices(void *destination, size_t count, size_t indexSize, uint32_t vertexCount, const uint8_t *data, size_t size) {
+    if (count % 3 != 0) {
+        return false;
+    }
+    if (indexSize == sizeof(uint16_t)) {
+        return decodeTriangles(static_cast<uint16_t *>(destination), count, vertexCount, data, data + size);
+    }
+    if (indexSize == sizeof(uint32_t)) {
+        return decodeTriangles(static_cast<uint32_t *>(destination), count, vertexCount, data, data + size);
+    }
+    return false;
+}
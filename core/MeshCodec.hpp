@@ -0,0 +1,30 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MESHCODEC_HPP
+#define VULKAN_EXPERIMENTS_MESHCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless compression of the cooked mesh streams, decoded straight into the staging buffer on upload. Indices shrink
+// about three times, float vertices by a third, quantized vertices hardly at all since their deltas are mostly noise
+class MeshCodec {
+public:
+    // every byte of a vertex is delta coded against the same byte of the previous vertex, the zigzagged deltas are
+    // packed in groups of 16 with 0, 2, 4 or 8 bits each. stride has to be a multiple of 4
+    static std::vector<uint8_t> encodeVertices(const void *vertices, size_t count, size_t stride);
+    // destination holds count * stride bytes, false when data is not a valid encoding of that many vertices
+    static bool decodeVertices(void *destination, size_t count, size_t stride, const uint8_t *data, size_t size);
+
+    // triangles are coded against a FIFO of edges of the triangles before them and a FIFO of recent vertices, a
+    // triangle next to a recent one takes a byte. The vertices of a triangle may come back rotated, keeping its winding
+    static std::vector<uint8_t> encodeIndices(const uint32_t *indices, size_t count);
+    // destination holds count indices of indexSize bytes, 2 or 4. False as well when an index is not below vertexCount
+    static bool decodeIndices(void *destination, size_t count, size_t indexSize, uint32_t vertexCount, const uint8_t *data, size_t size);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MESHCODEC_HPP
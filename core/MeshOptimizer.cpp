@@ -0,0 +1,398 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include "MeshOptimizer.hpp"
+
+namespace {
+
+constexpr int maxCacheSize = 32;
+constexpr uint32_t overdrawCacheSize = 16;
+constexpr uint32_t overdrawGridSize = 256;
+constexpr uint32_t minClusterTriangles = 16;
+
+// axes and cube diagonals, the directions overdraw is sorted and measured for
+const std::array<glm::vec3, 14> &getViewDirections() {
+    static const std::array<glm::vec3, 14> directions = []() {
+        std::array<glm::vec3, 14> result;
+        size_t count = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            for (float sign : {1.0f, -1.0f}) {
+                glm::vec3 direction(0.0f);
+                direction[axis] = sign;
+                result[count++] = direction;
+            }
+        }
+        for (float x : {1.0f, -1.0f}) {
+            for (float y : {1.0f, -1.0f}) {
+                for (float z : {1.0f, -1.0f}) {
+                    result[count++] = glm::normalize(glm::vec3(x, y, z));
+                }
+            }
+        }
+        return result;
+    }();
+    return directions;
+}
+
+// FIFO cache misses of the triangles in [first, last), starting with an empty cache
+class CacheSimulator {
+public:
+    explicit CacheSimulator(size_t vertexCount) : loadedAt(vertexCount, 0) {}
+
+    void reset() {
+        // everything loaded before now is far enough in the past to count as evicted
+        timestamp += overdrawCacheSize + 1;
+    }
+
+    uint32_t addTriangle(const uint32_t *triangle) {
+        uint32_t misses = 0;
+        for (int k = 0; k < 3; k++) {
+            if (timestamp - loadedAt[triangle[k]] > overdrawCacheSize) {
+                loadedAt[triangle[k]] = timestamp++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+private:
+    std::vector<uint32_t> loadedAt;
+    uint32_t timestamp = overdrawCacheSize + 1;
+};
+
+inline float edgeFunction(const glm::vec3 &a, const glm::vec3 &b, float x, float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+// score of a vertex by its position in the simulated LRU cache and the triangles still using it
+float vertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // the three vertices of the last triangle get a fixed score so the next one does not just reuse them
+        if (cachePosition < 3) {
+            score = 0.75f;
+        }
+        else {
+            score = std::pow(1.0f - float(cachePosition - 3) / float(maxCacheSize - 3), 1.5f);
+        }
+    }
+    // boost vertices with few triangles left so they get finished instead of leaving lone triangles behind
+    return score + 2.0f / std::sqrt(float(remainingTriangles));
+}
+
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // per vertex list of triangles that are not emitted yet, [offset, offset + remaining)
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices) {
+        remaining[index]++;
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[cursor[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        scores[v] = vertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int64_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+        if (triangleScores[t] > triangleScores[bestTriangle]) {
+            bestTriangle = static_cast<int64_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    uint32_t cache[maxCacheSize + 3];
+    int cacheCount = 0;
+    size_t scanCursor = 0;
+
+    while (result.size() < indices.size()) {
+        if (bestTriangle < 0) {
+            // nothing adjacent to the cache is left, continue with the next unused triangle
+            while (emitted[scanCursor]) scanCursor++;
+            bestTriangle = static_cast<int64_t>(scanCursor);
+        }
+        const uint32_t *triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = triangle[k];
+            result.push_back(v);
+            uint32_t *list = &adjacency[offsets[v]];
+            for (uint32_t i = 0; i < remaining[v]; i++) {
+                if (list[i] == bestTriangle) {
+                    list[i] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+
+        // the emitted triangle goes to the front, everything else shifts back
+        uint32_t newCache[maxCacheSize + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; k++) {
+            newCache[newCount++] = triangle[k];
+        }
+        for (int i = 0; i < cacheCount; i++) {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+        for (int i = 0; i < newCount; i++) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < maxCacheSize ? i : -1;
+            scores[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        bestTriangle = -1;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (int i = 0; i < newCount; i++) {
+            uint32_t v = newCache[i];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                uint32_t t = adjacency[offsets[v] + j];
+                float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, maxCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, float threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // hard boundaries where all three vertices miss, cutting there costs nothing
+    CacheSimulator cache(vertices.size());
+    std::vector<size_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (cache.addTriangle(&indices[t * 3]) == 3) {
+            hardBoundaries.push_back(t);
+        }
+    }
+    if (hardBoundaries.empty() || hardBoundaries[0] != 0) {
+        hardBoundaries.insert(hardBoundaries.begin(), 0);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // soft boundaries inside each hard range, a cluster ends once its ACMR is within the threshold of the range ACMR
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+        size_t first = hardBoundaries[h];
+        size_t last = hardBoundaries[h + 1];
+        cache.reset();
+        uint32_t rangeMisses = 0;
+        for (size_t t = first; t < last; t++) {
+            rangeMisses += cache.addTriangle(&indices[t * 3]);
+        }
+        float targetAcmr = float(rangeMisses) / float(last - first) * threshold;
+
+        cache.reset();
+        size_t clusterStart = first;
+        uint32_t clusterMisses = 0;
+        clusters.push_back(first);
+        for (size_t t = first; t + 1 < last; t++) {
+            clusterMisses += cache.addTriangle(&indices[t * 3]);
+            size_t clusterSize = t + 1 - clusterStart;
+            if (clusterSize >= minClusterTriangles && float(clusterMisses) / float(clusterSize) <= targetAcmr) {
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                clusters.push_back(clusterStart);
+                cache.reset();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const auto &vertex : vertices) {
+        meshCentroid += vertex.position;
+    }
+    meshCentroid /= float(std::max<size_t>(vertices.size(), 1));
+
+    // a cluster facing a view and lying towards it should be drawn before the ones behind it,
+    // the sort key sums that front-ness over every view the cluster faces
+    const auto &views = getViewDirections();
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const glm::vec3 &a = vertices[indices[t * 3]].position;
+            const glm::vec3 &b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3 &p = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 weightedNormal = glm::cross(b - a, p - a);
+            float triangleArea = glm::length(weightedNormal);
+            centroid += (a + b + p) * (triangleArea / 3.0f);
+            normal += weightedNormal;
+            area += triangleArea;
+        }
+        centroid = area > 0.0f ? centroid / area : vertices[indices[clusters[c] * 3]].position;
+        float normalLength = glm::length(normal);
+        normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+
+        float key = 0.0f;
+        for (const auto &view : views) {
+            key += std::max(0.0f, glm::dot(normal, view)) * glm::dot(centroid - meshCentroid, view);
+        }
+        sortKeys[c] = key;
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) { return sortKeys[lhs] > sortKeys[rhs]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t c : order) {
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) {
+    std::vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (auto &index : indices) {
+        if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize) {
+    VertexCacheStatistics statistics;
+    if (indices.empty() || vertexCount == 0) {
+        return statistics;
+    }
+    // a vertex is in the FIFO while fewer than cacheSize misses happened after it was loaded
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    for (uint32_t index : indices) {
+        if (timestamp - loadedAt[index] > cacheSize) {
+            loadedAt[index] = timestamp++;
+            statistics.vertexTransforms++;
+        }
+    }
+    statistics.acmr = float(statistics.vertexTransforms) / float(indices.size() / 3);
+    statistics.atvr = float(statistics.vertexTransforms) / float(vertexCount);
+    return statistics;
+}
+
+OverdrawStatistics MeshOptimizer::analyzeOverdraw(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices) {
+    OverdrawStatistics statistics;
+    if (indices.empty()) {
+        return statistics;
+    }
+    glm::vec3 boundsMin = vertices[0].position;
+    glm::vec3 boundsMax = vertices[0].position;
+    for (const auto &vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = std::max(glm::length(boundsMax - center), 1e-6f);
+    const float scale = float(overdrawGridSize) * 0.5f / radius;
+
+    std::vector<glm::vec3> projected(vertices.size());
+    std::vector<float> depth(overdrawGridSize * overdrawGridSize);
+    for (const auto &view : getViewDirections()) {
+        // orthographic camera on the view side looking back at the mesh, x right, y up, smaller depth is closer
+        glm::vec3 up = std::abs(view.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 right = glm::normalize(glm::cross(up, view));
+        up = glm::cross(view, right);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            glm::vec3 p = vertices[i].position - center;
+            projected[i] = {glm::dot(p, right) * scale + float(overdrawGridSize) * 0.5f,
+                            glm::dot(p, up) * scale + float(overdrawGridSize) * 0.5f,
+                            -glm::dot(p, view)};
+        }
+        std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3 &a = projected[indices[t]];
+            const glm::vec3 &b = projected[indices[t + 1]];
+            const glm::vec3 &c = projected[indices[t + 2]];
+            float area = edgeFunction(a, b, c.x, c.y);
+            // counter-clockwise triangles are front facing, the rest is culled
+            if (area <= 0.0f) {
+                continue;
+            }
+            int minX = std::max(0, int(std::floor(std::min({a.x, b.x, c.x}))));
+            int maxX = std::min(int(overdrawGridSize) - 1, int(std::ceil(std::max({a.x, b.x, c.x}))));
+            int minY = std::max(0, int(std::floor(std::min({a.y, b.y, c.y}))));
+            int maxY = std::min(int(overdrawGridSize) - 1, int(std::ceil(std::max({a.y, b.y, c.y}))));
+            for (int y = minY; y <= maxY; y++) {
+                for (int x = minX; x <= maxX; x++) {
+                    float px = float(x) + 0.5f;
+                    float py = float(y) + 0.5f;
+                    float w0 = edgeFunction(b, c, px, py);
+                    float w1 = edgeFunction(c, a, px, py);
+                    float w2 = edgeFunction(a, b, px, py);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                        continue;
+                    }
+                    float z = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+                    float &stored = depth[y * overdrawGridSize + x];
+                    if (z < stored) {
+                        stored = z;
+                        statistics.pixelsShaded++;
+                    }
+                }
+            }
+        }
+        for (float value : depth) {
+            if (value != std::numeric_limits<float>::max()) {
+                statistics.pixelsCovered++;
+            }
+        }
+    }
+    statistics.overdraw = statistics.pixelsCovered > 0 ? float(statistics.pixelsShaded) / float(statistics.pixelsCovered) : 0.0f;
+    return statistics;
+}
@@ -0,0 +1,44 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MESHOPTIMIZER_HPP
+#define VULKAN_EXPERIMENTS_MESHOPTIMIZER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Mesh.hpp"
+
+struct VertexCacheStatistics {
+    uint32_t vertexTransforms = 0;
+    // average cache miss ratio, transformed vertices per triangle
+    float acmr = 0.0f;
+    // average transform to vertex ratio, 1.0 means every vertex is transformed once
+    float atvr = 0.0f;
+};
+
+struct OverdrawStatistics {
+    uint32_t pixelsCovered = 0;
+    uint32_t pixelsShaded = 0;
+    // shaded fragments per covered pixel, 1.0 means no overdraw
+    float overdraw = 0.0f;
+};
+
+// Offline index and vertex buffer reordering, runs at import time
+class MeshOptimizer {
+public:
+    // Forsyth's linear-speed triangle reordering for the post-transform vertex cache
+    static void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+    // split the cache optimised order into clusters and sort them front to back over a set of view directions,
+    // each cluster keeps an ACMR within threshold times the ACMR of the range it was cut from
+    static void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, float threshold);
+    // renumber vertices in order of first use so vertex fetch walks the buffer sequentially, drops unused ones
+    static void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+    // simulate a FIFO post-transform cache of the given size
+    static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+    // rasterize the mesh on the CPU from the same view directions with depth test and back-face culling
+    static OverdrawStatistics analyzeOverdraw(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MESHOPTIMIZER_HPP
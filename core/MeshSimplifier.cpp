@@ -0,0 +1,364 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+#include "Mesh.hpp"
+
+namespace {
+
+constexpr uint32_t noVertex = UINT32_MAX;
+// planes across open edges are weighted up so that borders and seams keep their shape
+constexpr double borderWeight = 10.0;
+
+bool lessPosition(const glm::vec3 &a, const glm::vec3 &b) {
+    if (a.x != b.x) return a.x < b.x;
+    if (a.y != b.y) return a.y < b.y;
+    return a.z < b.z;
+}
+
+}
+
+void MeshSimplifier::Quadric::addPlane(const glm::vec3 &normal, float distance, double planeWeight) {
+    double x = normal.x, y = normal.y, z = normal.z, d = distance;
+    a00 += planeWeight * x * x;
+    a11 += planeWeight * y * y;
+    a22 += planeWeight * z * z;
+    a10 += planeWeight * y * x;
+    a20 += planeWeight * z * x;
+    a21 += planeWeight * z * y;
+    b0 += planeWeight * x * d;
+    b1 += planeWeight * y * d;
+    b2 += planeWeight * z * d;
+    c += planeWeight * d * d;
+}
+
+void MeshSimplifier::Quadric::add(const Quadric &other) {
+    a00 += other.a00;
+    a11 += other.a11;
+    a22 += other.a22;
+    a10 += other.a10;
+    a20 += other.a20;
+    a21 += other.a21;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+}
+
+float MeshSimplifier::Quadric::getError(const glm::vec3 &point) const {
+    if (weight <= 0.0) {
+        return 0.0f;
+    }
+    double x = point.x, y = point.y, z = point.z;
+    double result = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z) +
+                    2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    return static_cast<float>(std::sqrt(std::max(result, 0.0) / weight));
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices)
+    : vertices(vertices), indices(indices) {
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    remap.resize(vertexCount);
+    wedges.resize(vertexCount);
+    collapseRemap.resize(vertexCount);
+    collapseLocked.resize(vertexCount);
+
+    // group vertices by position, the lowest index of a group represents it
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const glm::vec3 &pa = vertices[a].position, &pb = vertices[b].position;
+        return pa != pb ? lessPosition(pa, pb) : a < b;
+    });
+    for (size_t first = 0; first < order.size();) {
+        size_t last = first + 1;
+        while (last < order.size() && vertices[order[last]].position == vertices[order[first]].position) last++;
+        for (size_t i = first; i < last; i++) {
+            remap[order[i]] = order[first];
+            wedges[order[i]] = order[i + 1 < last ? i + 1 : first];
+        }
+        first = last;
+    }
+
+    buildAdjacency();
+    classifyVertices();
+    computeQuadrics();
+}
+
+void MeshSimplifier::buildAdjacency() {
+    adjacencyOffsets.assign(vertices.size() + 1, 0);
+    for (uint32_t index : indices) {
+        adjacencyOffsets[index + 1]++;
+    }
+    for (size_t i = 0; i < vertices.size(); i++) {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+    adjacency.resize(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+}
+
+bool MeshSimplifier::hasEdge(uint32_t a, uint32_t b) const {
+    for (uint32_t i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++) {
+        const uint32_t *triangle = &indices[adjacency[i] * 3];
+        for (uint32_t k = 0; k < 3; k++) {
+            if (triangle[k] == a && triangle[(k + 1) % 3] == b) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void MeshSimplifier::classifyVertices() {
+    // an edge without its reverse is open, a vertex with more than one open edge each way refers to itself
+    loopOut.assign(vertices.size(), noVertex);
+    loopIn.assign(vertices.size(), noVertex);
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t a = indices[i];
+        uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+        if (!hasEdge(b, a)) {
+            loopOut[a] = loopOut[a] == noVertex ? b : a;
+            loopIn[b] = loopIn[b] == noVertex ? a : b;
+        }
+    }
+
+    kinds.assign(vertices.size(), VertexKind::MANIFOLD);
+    for (uint32_t i = 0; i < vertices.size(); i++) {
+        if (remap[i] != i) {
+            continue;
+        }
+        auto isLoop = [&](uint32_t vertex) {
+            return loopOut[vertex] != noVertex && loopIn[vertex] != noVertex && loopOut[vertex] != vertex && loopIn[vertex] != vertex;
+        };
+        if (wedges[i] == i) {
+            if (loopOut[i] == noVertex && loopIn[i] == noVertex) {
+                kinds[i] = VertexKind::MANIFOLD;
+            }
+            else {
+                kinds[i] = isLoop(i) ? VertexKind::BORDER : VertexKind::LOCKED;
+            }
+        }
+        else if (wedges[wedges[i]] == i) {
+            // two wedges whose open edges run along the same positions in opposite directions
+            uint32_t w = wedges[i];
+            bool seam = isLoop(i) && isLoop(w) && remap[loopIn[i]] == remap[loopOut[w]] && remap[loopOut[i]] == remap[loopIn[w]] &&
+                        remap[loopIn[i]] != remap[loopOut[i]];
+            kinds[i] = seam ? VertexKind::SEAM : VertexKind::LOCKED;
+        }
+        else {
+            kinds[i] = VertexKind::LOCKED;
+        }
+    }
+    for (uint32_t i = 0; i < vertices.size(); i++) {
+        kinds[i] = kinds[remap[i]];
+    }
+}
+
+void MeshSimplifier::computeQuadrics() {
+    quadrics.assign(vertices.size(), {});
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        const glm::vec3 &p0 = vertices[indices[t]].position;
+        glm::vec3 normal = glm::cross(vertices[indices[t + 1]].position - p0, vertices[indices[t + 2]].position - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f) {
+            continue;
+        }
+        normal /= length;
+        for (uint32_t k = 0; k < 3; k++) {
+            auto &quadric = quadrics[remap[indices[t + k]]];
+            quadric.addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+            quadric.weight += length * 0.5;
+        }
+        // a plane through every open edge perpendicular to its triangle
+        for (uint32_t k = 0; k < 3; k++) {
+            uint32_t a = indices[t + k], b = indices[t + (k + 1) % 3];
+            if (hasEdge(b, a)) {
+                continue;
+            }
+            glm::vec3 edge = vertices[b].position - vertices[a].position;
+            glm::vec3 edgeNormal = glm::cross(edge, normal);
+            float edgeNormalLength = glm::length(edgeNormal);
+            if (edgeNormalLength == 0.0f) {
+                continue;
+            }
+            edgeNormal /= edgeNormalLength;
+            double edgeWeight = glm::dot(edge, edge) * borderWeight;
+            float distance = -glm::dot(edgeNormal, vertices[a].position);
+            quadrics[remap[a]].addPlane(edgeNormal, distance, edgeWeight);
+            quadrics[remap[b]].addPlane(edgeNormal, distance, edgeWeight);
+        }
+    }
+}
+
+bool MeshSimplifier::canCollapse(uint32_t from, uint32_t to) const {
+    if (remap[from] == remap[to]) {
+        return false;
+    }
+    VertexKind target = kinds[to];
+    // border and seam vertices only move to their neighbours along the loop
+    bool alongLoop = to == loopOut[from] || to == loopIn[from];
+    switch (kinds[from]) {
+        case VertexKind::MANIFOLD:
+            return true;
+        case VertexKind::BORDER:
+            return alongLoop && (target == VertexKind::BORDER || target == VertexKind::LOCKED);
+        case VertexKind::SEAM:
+            return alongLoop && (target == VertexKind::SEAM || target == VertexKind::LOCKED);
+        default:
+            return false;
+    }
+}
+
+bool MeshSimplifier::flipsTriangles(uint32_t from, uint32_t to) const {
+    const glm::vec3 &target = vertices[to].position;
+    uint32_t wedge = from;
+    do {
+        for (uint32_t i = adjacencyOffsets[wedge]; i < adjacencyOffsets[wedge + 1]; i++) {
+            const uint32_t *triangle = &indices[adjacency[i] * 3];
+            // triangles on the collapsed edge disappear
+            if (remap[triangle[0]] == remap[to] || remap[triangle[1]] == remap[to] || remap[triangle[2]] == remap[to]) {
+                continue;
+            }
+            glm::vec3 before[3], after[3];
+            for (uint32_t k = 0; k < 3; k++) {
+                before[k] = vertices[triangle[k]].position;
+                after[k] = triangle[k] == wedge ? target : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+                return true;
+            }
+        }
+        wedge = wedges[wedge];
+    } while (wedge != from);
+    return false;
+}
+
+size_t MeshSimplifier::collapseEdges(size_t triangleGoal, float maxError) {
+    std::vector<Collapse> collapses;
+    collapses.reserve(indices.size());
+    auto addCollapse = [&](uint32_t from, uint32_t to) {
+        if (canCollapse(from, to)) {
+            collapses.push_back({from, to, quadrics[remap[from]].getError(vertices[to].position)});
+        }
+    };
+    // interior edges are seen from both of their triangles, open ones only once
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t a = indices[i];
+        uint32_t b = indices[i - i % 3 + (i + 1) % 3];
+        addCollapse(a, b);
+        if (!hasEdge(b, a)) {
+            addCollapse(b, a);
+        }
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+    if (collapses.empty()) {
+        return 0;
+    }
+    // many collapses of a pass are blocked by a neighbour that already moved, the pass may go somewhat past the error
+    // of the collapse that would reach the goal if all of them went through but not further
+    size_t edgeGoal = std::min(triangleGoal / 2, collapses.size() - 1);
+    float errorLimit = std::min(maxError, collapses[edgeGoal].error * 1.5f);
+
+    std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+    std::fill(collapseLocked.begin(), collapseLocked.end(), false);
+    auto moveLoop = [&](uint32_t vertex, uint32_t target) {
+        if (target == loopOut[vertex]) {
+            loopIn[target] = loopIn[vertex];
+        }
+        else if (target == loopIn[vertex]) {
+            loopOut[target] = loopOut[vertex];
+        }
+    };
+
+    // cheapest first, a vertex takes part in one collapse per pass so every error is measured against fresh quadrics
+    size_t removed = 0;
+    for (const auto &collapse : collapses) {
+        if (collapse.error > errorLimit || removed >= triangleGoal) {
+            break;
+        }
+        uint32_t from = collapse.from, to = collapse.to;
+        if (collapseLocked[remap[from]] || collapseLocked[remap[to]] || flipsTriangles(from, to)) {
+            continue;
+        }
+        if (kinds[from] == VertexKind::SEAM) {
+            // the twin moves along its side of the seam to the matching wedge of the target
+            uint32_t twin = wedges[from];
+            uint32_t twinTarget = to == loopOut[from] ? loopIn[twin] : loopOut[twin];
+            collapseRemap[twin] = twinTarget;
+            moveLoop(twin, twinTarget);
+        }
+        if (kinds[from] != VertexKind::MANIFOLD) {
+            moveLoop(from, to);
+        }
+        collapseRemap[from] = to;
+        quadrics[remap[to]].add(quadrics[remap[from]]);
+        collapseLocked[remap[from]] = true;
+        collapseLocked[remap[to]] = true;
+        error = std::max(error, collapse.error);
+        removed += kinds[from] == VertexKind::BORDER ? 1 : 2;
+    }
+    if (removed == 0) {
+        return 0;
+    }
+
+    size_t kept = 0;
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        uint32_t a = collapseRemap[indices[t]], b = collapseRemap[indices[t + 1]], c = collapseRemap[indices[t + 2]];
+        if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c]) {
+            continue;
+        }
+        indices[kept++] = a;
+        indices[kept++] = b;
+        indices[kept++] = c;
+    }
+    indices.resize(kept);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (loopOut[i] != noVertex) loopOut[i] = collapseRemap[loopOut[i]];
+        if (loopIn[i] != noVertex) loopIn[i] = collapseRemap[loopIn[i]];
+    }
+    return removed;
+}
+
+void MeshSimplifier::simplify(size_t targetIndexCount, float maxError) {
+    while (indices.size() > targetIndexCount) {
+        buildAdjacency();
+        if (collapseEdges((indices.size() - targetIndexCount) / 3, maxError) == 0) {
+            break;
+        }
+    }
+}
+
+std::vector<MeshLod> MeshSimplifier::buildLods(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, uint32_t maxLods, float maxError) {
+    std::vector<MeshLod> lods;
+    lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+    if (maxLods <= 1 || indices.empty()) {
+        return lods;
+    }
+    MeshSimplifier simplifier(indices, vertices);
+    size_t previousCount = indices.size();
+    while (lods.size() < maxLods) {
+        simplifier.simplify(previousCount / 6 * 3, maxError);
+        size_t count = simplifier.getIndices().size();
+        // seams and the error limit can stop the simplifier early, a lod that saves little is not worth switching to
+        if (count == 0 || count > previousCount * 3 / 4) {
+            break;
+        }
+        std::vector<uint32_t> lodIndices = simplifier.getIndices();
+        MeshOptimizer::optimizeVertexCache(lodIndices, static_cast<uint32_t>(vertices.size()));
+        lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count), simplifier.getError()});
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        previousCount = count;
+    }
+    return lods;
+}
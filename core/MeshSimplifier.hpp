@@ -0,0 +1,96 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MESHSIMPLIFIER_HPP
+#define VULKAN_EXPERIMENTS_MESHSIMPLIFIER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+struct Vertex;
+
+// One level of detail, a range of the shared index buffer
+struct MeshLod {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    // largest distance of the simplified surface from the full resolution one, in object space units
+    float error = 0.0f;
+    uint32_t padding = 0;
+};
+static_assert(sizeof(MeshLod) == 16);
+
+// Quadric error edge collapse over an indexed triangle list. Vertices that share a position but not their attributes
+// lie on a uv seam, they only slide along the seam together with their twin so the texture layout stays intact,
+// open borders are kept the same way and anything more complex is never moved
+class MeshSimplifier {
+public:
+    MeshSimplifier(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices);
+
+    // collapse edges until at most targetIndexCount indices are left or the cheapest collapse would move the surface
+    // further than maxError, every call continues from the result of the previous one
+    void simplify(size_t targetIndexCount, float maxError);
+    const std::vector<uint32_t> &getIndices() const { return indices; }
+    float getError() const { return error; }
+
+    // append up to maxLods - 1 coarser versions of the whole index buffer to it, each with about half the triangles
+    // of the previous one, the first lod is the index buffer as it was
+    static std::vector<MeshLod> buildLods(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, uint32_t maxLods, float maxError);
+
+private:
+    enum class VertexKind : uint8_t {
+        MANIFOLD,
+        BORDER,
+        SEAM,
+        LOCKED,
+    };
+
+    // symmetric 4x4 error matrix of the planes around a vertex, weighted by triangle area
+    struct Quadric {
+        double a00 = 0.0, a11 = 0.0, a22 = 0.0, a10 = 0.0, a20 = 0.0, a21 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0, c = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const glm::vec3 &normal, float distance, double planeWeight);
+        void add(const Quadric &other);
+        // mean distance to the planes at point
+        float getError(const glm::vec3 &point) const;
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        float error;
+    };
+
+    void classifyVertices();
+    void computeQuadrics();
+    void buildAdjacency();
+    bool hasEdge(uint32_t a, uint32_t b) const;
+    bool canCollapse(uint32_t from, uint32_t to) const;
+    bool flipsTriangles(uint32_t from, uint32_t to) const;
+    size_t collapseEdges(size_t triangleGoal, float maxError);
+
+    const std::vector<Vertex> &vertices;
+    std::vector<uint32_t> indices;
+    float error = 0.0f;
+
+    // first vertex with the same position, the vertices of one position are linked in a ring through wedges
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> wedges;
+    std::vector<VertexKind> kinds;
+    // other end of the open edge leaving and entering a border or seam vertex
+    std::vector<uint32_t> loopOut;
+    std::vector<uint32_t> loopIn;
+    // per position
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> collapseRemap;
+    std::vector<bool> collapseLocked;
+    // vertex to triangle adjacency of the current indices in compressed rows
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MESHSIMPLIFIER_HPP
@@ -0,0 +1,219 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <cmath>
+#include <cstdint>
+#include "Meshlet.hpp"
+#include "Mesh.hpp"
+
+namespace {
+
+void computeMeshletBounds(Meshlet &meshlet, const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices) {
+    uint32_t first = meshlet.indexOffset;
+    uint32_t last = meshlet.indexOffset + meshlet.triangleCount * 3;
+
+    Bounds bounds = computeBounds(vertices.data(), &indices[first], last - first);
+    BoundingSphere sphere = computeBoundingSphere(vertices.data(), &indices[first], last - first, bounds);
+    meshlet.center = sphere.center;
+    meshlet.radius = sphere.radius;
+    meshlet.halfExtent = bounds.getHalfExtent();
+
+    // normal cone around the average face normal, degenerate triangles have no say in it
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = first; i < last; i += 3) {
+        const glm::vec3 &p0 = vertices[indices[i]].position;
+        glm::vec3 normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            corners.push_back(p0);
+            axis += normal / length;
+        }
+    }
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0.0f);
+    meshlet.coneCutoff = 1.0f;
+    float axisLength = glm::length(axis);
+    if (axisLength == 0.0f) {
+        return;
+    }
+    axis /= axisLength;
+    float minDot = 1.0f;
+    for (const auto &normal : normals) {
+        minDot = std::min(minDot, glm::dot(axis, normal));
+    }
+    // a cone wider than ~84 degrees almost never culls, a cutoff of 1 disables the test
+    if (minDot <= 0.1f) {
+        return;
+    }
+    // move the apex back along the axis until every triangle plane is in front of it
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); i++) {
+        float t = glm::dot(meshlet.center - corners[i], normals[i]) / glm::dot(axis, normals[i]);
+        maxT = std::max(maxT, t);
+    }
+    meshlet.coneApex = meshlet.center - axis * maxT;
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+}
+
+MeshletCullView MeshletCullView::create(const Frustum &worldFrustum, const glm::vec3 &worldCameraPosition, const glm::mat4 &model) {
+    MeshletCullView view{};
+    view.frustum = worldFrustum.toObjectSpace(model);
+    view.cameraPosition = glm::vec3(glm::inverse(model) * glm::vec4(worldCameraPosition, 1.0f));
+    view.radiusScale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    return view;
+}
+
+bool MeshletCullView::isVisible(const Meshlet &meshlet) const {
+    if (!frustum.intersectsSphere(meshlet.center, meshlet.radius * radiusScale) || !frustum.intersectsBox(meshlet.center, meshlet.halfExtent)) {
+        return false;
+    }
+    glm::vec3 direction = meshlet.coneApex - cameraPosition;
+    float distance = glm::length(direction);
+    return distance == 0.0f || glm::dot(direction / distance, meshlet.coneAxis) < meshlet.coneCutoff;
+}
+
+MeshletCullConstants MeshletCullView::getConstants(uint32_t meshletCount) const {
+    MeshletCullConstants constants{};
+    for (int i = 0; i < 6; i++) {
+        constants.frustumPlanes[i] = frustum.planes[i];
+    }
+    constants.cameraPosition = glm::vec4(cameraPosition, radiusScale);
+    constants.meshletCount = meshletCount;
+    return constants;
+}
+
+std::vector<Meshlet> MeshletBuilder::build(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices) {
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+    // vertex to triangle adjacency in compressed rows
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t index : indices) {
+        adjacencyOffsets[index + 1]++;
+    }
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        centroids[t] = (vertices[indices[t * 3]].position + vertices[indices[t * 3 + 1]].position + vertices[indices[t * 3 + 2]].position) / 3.0f;
+    }
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<bool> emitted(triangleCount, false);
+    // meshlet number + 1 of the meshlet that last referenced the vertex
+    std::vector<uint32_t> vertexOwner(vertexCount, 0);
+    std::vector<uint32_t> candidates;
+    uint32_t nextSeed = 0;
+
+    while (true) {
+        while (nextSeed < triangleCount && emitted[nextSeed]) nextSeed++;
+        if (nextSeed == triangleCount) {
+            break;
+        }
+        Meshlet meshlet{};
+        meshlet.indexOffset = static_cast<uint32_t>(result.size());
+        uint32_t owner = static_cast<uint32_t>(meshlets.size()) + 1;
+        glm::vec3 centroidSum(0.0f);
+        candidates.clear();
+        uint32_t triangle = nextSeed;
+
+        // grow the meshlet over shared vertices, preferring triangles that add the fewest vertices and then the
+        // ones closest to its center, it is closed when full or when nothing adjacent is left
+        while (true) {
+            emitted[triangle] = true;
+            centroidSum += centroids[triangle];
+            for (uint32_t j = 0; j < 3; j++) {
+                uint32_t vertex = indices[triangle * 3 + j];
+                result.push_back(vertex);
+                if (vertexOwner[vertex] != owner) {
+                    vertexOwner[vertex] = owner;
+                    meshlet.vertexCount++;
+                    for (uint32_t k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; k++) {
+                        if (!emitted[adjacency[k]]) candidates.push_back(adjacency[k]);
+                    }
+                }
+            }
+            meshlet.triangleCount++;
+            if (meshlet.triangleCount == Meshlet::MAX_TRIANGLES) {
+                break;
+            }
+
+            glm::vec3 center = centroidSum / float(meshlet.triangleCount);
+            uint32_t best = UINT32_MAX;
+            uint32_t bestNewVertices = 4;
+            float bestDistance = 0.0f;
+            size_t kept = 0;
+            for (size_t c = 0; c < candidates.size(); c++) {
+                uint32_t candidate = candidates[c];
+                if (emitted[candidate]) {
+                    continue;
+                }
+                candidates[kept++] = candidate;
+                uint32_t a = indices[candidate * 3], b = indices[candidate * 3 + 1], d = indices[candidate * 3 + 2];
+                uint32_t newVertices = (vertexOwner[a] != owner) + (vertexOwner[b] != owner && b != a) + (vertexOwner[d] != owner && d != a && d != b);
+                if (meshlet.vertexCount + newVertices > Meshlet::MAX_VERTICES) {
+                    continue;
+                }
+                glm::vec3 offset = centroids[candidate] - center;
+                float distance = glm::dot(offset, offset);
+                if (newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance)) {
+                    best = candidate;
+                    bestNewVertices = newVertices;
+                    bestDistance = distance;
+                }
+            }
+            candidates.resize(kept);
+            if (best == UINT32_MAX) {
+                break;
+            }
+            triangle = best;
+        }
+        meshlets.push_back(meshlet);
+    }
+    indices.swap(result);
+
+    for (auto &meshlet : meshlets) {
+        computeMeshletBounds(meshlet, indices, vertices);
+    }
+    return meshlets;
+}
+
+uint32_t MeshletBuilder::cull(const Mesh &mesh, const MeshletCullView &view, std::vector<IndexRange> &visibleRanges) {
+    const Meshlet *meshlets = mesh.getMeshlets();
+    uint32_t visibleCount = 0;
+    size_t firstRange = visibleRanges.size();
+    for (uint32_t i = 0; i < mesh.getMeshletCount(); i++) {
+        if (!view.isVisible(meshlets[i])) {
+            continue;
+        }
+        visibleCount++;
+        uint32_t indexCount = meshlets[i].triangleCount * 3;
+        if (visibleRanges.size() > firstRange) {
+            auto &last = visibleRanges.back();
+            if (last.firstIndex + last.indexCount == meshlets[i].indexOffset) {
+                last.indexCount += indexCount;
+                continue;
+            }
+        }
+        visibleRanges.push_back({meshlets[i].indexOffset, indexCount});
+    }
+    return visibleCount;
+}
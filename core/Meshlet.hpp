@@ -0,0 +1,77 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_MESHLET_HPP
+#define VULKAN_EXPERIMENTS_MESHLET_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Frustum.hpp"
+
+struct Vertex;
+struct Mesh;
+
+// Cluster of consecutive triangles of the index buffer with its culling data, laid out like the std430 struct
+// of meshlet_cull.comp
+struct Meshlet {
+    static constexpr uint32_t MAX_VERTICES = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    // center of the bounding box and of the bounding sphere around it
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 halfExtent = glm::vec3(0.0f);
+    uint32_t vertexCount = 0;
+    // the cluster faces away from every camera inside the cone with this apex, -axis direction and cutoff
+    glm::vec3 coneApex = glm::vec3(0.0f);
+    float coneCutoff = 1.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f);
+    uint32_t indexOffset = 0;
+    uint32_t triangleCount = 0;
+    uint32_t padding[3] = {};
+};
+static_assert(sizeof(Meshlet) == 80);
+
+// push constants of meshlet_cull.comp
+struct MeshletCullConstants {
+    glm::vec4 frustumPlanes[6];
+    // xyz is the camera in object space, w the scale from object to world radius
+    glm::vec4 cameraPosition;
+    uint32_t meshletCount;
+    // first draw written, instances of one mesh write their draws into separate ranges of its draw buffer
+    uint32_t drawOffset;
+    // where the mesh starts in the geometry megabuffers, added to every draw
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+};
+static_assert(sizeof(MeshletCullConstants) == 128);
+
+struct IndexRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// Everything a meshlet is tested against, moved into the object space of one mesh instance
+struct MeshletCullView {
+    Frustum frustum;
+    glm::vec3 cameraPosition;
+    float radiusScale;
+
+    static MeshletCullView create(const Frustum &worldFrustum, const glm::vec3 &worldCameraPosition, const glm::mat4 &model);
+    bool isVisible(const Meshlet &meshlet) const;
+    MeshletCullConstants getConstants(uint32_t meshletCount) const;
+};
+
+class MeshletBuilder {
+public:
+    // group connected triangles into meshlets within the limits and reorder the index buffer so that every
+    // meshlet is one contiguous range of it
+    static std::vector<Meshlet> build(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices);
+    // append the index ranges of the visible meshlets, neighbours are merged into one range
+    static uint32_t cull(const Mesh &mesh, const MeshletCullView &view, std::vector<IndexRange> &visibleRanges);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_MESHLET_HPP
@@ -0,0 +1,259 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include "ObjLoader.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+constexpr size_t minChunkSize = 1 << 20;
+
+struct ElementCounts {
+    size_t positions = 0;
+    size_t normals = 0;
+    size_t texcoords = 0;
+    size_t triangles = 0;
+};
+
+struct Chunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    ElementCounts counts;
+    // number of elements in all previous chunks
+    ElementCounts offsets;
+};
+
+enum class LineType {
+    OTHER,
+    POSITION,
+    NORMAL,
+    TEXCOORD,
+    FACE,
+};
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+inline const char *skipToken(const char *p, const char *end) {
+    while (p < end && !isSpace(*p) && *p != '\n') p++;
+    return p;
+}
+
+inline const char *nextLine(const char *p, const char *end) {
+    auto newline = static_cast<const char *>(memchr(p, '\n', end - p));
+    return newline ? newline + 1 : end;
+}
+
+// moves p past the keyword of the line
+inline LineType classifyLine(const char *&p, const char *end) {
+    p = skipSpaces(p, end);
+    if (end - p >= 2 && p[0] == 'v' && isSpace(p[1])) {
+        p += 2;
+        return LineType::POSITION;
+    }
+    if (end - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+        p += 3;
+        return LineType::NORMAL;
+    }
+    if (end - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+        p += 3;
+        return LineType::TEXCOORD;
+    }
+    if (end - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+        p += 2;
+        return LineType::FACE;
+    }
+    return LineType::OTHER;
+}
+
+inline const char *parseFloat(const char *p, const char *end, float &value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+') p++;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        value = 0.0f;
+        return skipToken(p, end);
+    }
+    return result.ptr;
+}
+
+inline size_t countFaceCorners(const char *p, const char *end) {
+    size_t corners = 0;
+    p = skipSpaces(p, end);
+    while (p < end && *p != '\n') {
+        corners++;
+        p = skipSpaces(skipToken(p, end), end);
+    }
+    return corners;
+}
+
+// OBJ indices are 1-based, negative ones are relative to the elements defined so far
+inline int32_t resolveIndex(int32_t index, size_t definedCount) {
+    if (index > 0) return index - 1;
+    if (index < 0) return static_cast<int32_t>(definedCount) + index;
+    return -1;
+}
+
+inline const char *parseFaceCorner(const char *p, const char *end, const ElementCounts &defined, ObjIndex &corner) {
+    int32_t value = 0;
+    auto result = std::from_chars(p, end, value);
+    corner.position = result.ec == std::errc() ? resolveIndex(value, defined.positions) : -1;
+    p = result.ptr;
+    if (p < end && *p == '/') {
+        p++;
+        if (p < end && *p != '/') {
+            result = std::from_chars(p, end, value);
+            if (result.ec == std::errc()) {
+                corner.texcoord = resolveIndex(value, defined.texcoords);
+            }
+            p = result.ptr;
+        }
+        if (p < end && *p == '/') {
+            p++;
+            result = std::from_chars(p, end, value);
+            if (result.ec == std::errc()) {
+                corner.normal = resolveIndex(value, defined.normals);
+            }
+            p = result.ptr;
+        }
+    }
+    return skipToken(p, end);
+}
+
+void countChunk(Chunk &chunk) {
+    for (const char *line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end)) {
+        const char *p = line;
+        switch (classifyLine(p, chunk.end)) {
+            case LineType::POSITION: chunk.counts.positions++; break;
+            case LineType::NORMAL: chunk.counts.normals++; break;
+            case LineType::TEXCOORD: chunk.counts.texcoords++; break;
+            case LineType::FACE: {
+                size_t corners = countFaceCorners(p, chunk.end);
+                if (corners >= 3) chunk.counts.triangles += corners - 2;
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+void parseChunk(const Chunk &chunk, ObjData &data) {
+    // elements defined before the current line, for relative face indices
+    ElementCounts defined = chunk.offsets;
+    size_t corner = chunk.offsets.triangles * 3;
+    for (const char *line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end)) {
+        const char *p = line;
+        switch (classifyLine(p, chunk.end)) {
+            case LineType::POSITION: {
+                auto &position = data.positions[defined.positions++];
+                p = parseFloat(p, chunk.end, position.x);
+                p = parseFloat(p, chunk.end, position.y);
+                parseFloat(p, chunk.end, position.z);
+                break;
+            }
+            case LineType::NORMAL: {
+                auto &normal = data.normals[defined.normals++];
+                p = parseFloat(p, chunk.end, normal.x);
+                p = parseFloat(p, chunk.end, normal.y);
+                parseFloat(p, chunk.end, normal.z);
+                break;
+            }
+            case LineType::TEXCOORD: {
+                auto &texcoord = data.texcoords[defined.texcoords++];
+                p = parseFloat(p, chunk.end, texcoord.x);
+                parseFloat(p, chunk.end, texcoord.y);
+                break;
+            }
+            case LineType::FACE: {
+                if (countFaceCorners(p, chunk.end) < 3) break;
+                ObjIndex first, previous, current;
+                size_t cornerIndex = 0;
+                p = skipSpaces(p, chunk.end);
+                while (p < chunk.end && *p != '\n') {
+                    current = {};
+                    p = skipSpaces(parseFaceCorner(p, chunk.end, defined, current), chunk.end);
+                    if (cornerIndex == 0) {
+                        first = current;
+                    }
+                    else if (cornerIndex >= 2) {
+                        data.corners[corner++] = first;
+                        data.corners[corner++] = previous;
+                        data.corners[corner++] = current;
+                    }
+                    previous = current;
+                    cornerIndex++;
+                }
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+}
+
+bool ObjLoader::load(const char *path, ObjData &data) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+    const char *begin = file.data();
+    const char *end = begin + file.size();
+
+    auto &pool = ThreadPool::global();
+    size_t chunkCount = std::clamp<size_t>(file.size() / minChunkSize, 1, (pool.getThreadCount() + 1) * 4);
+    std::vector<Chunk> chunks(chunkCount);
+    const char *chunkBegin = begin;
+    for (size_t i = 0; i < chunkCount; i++) {
+        const char *chunkEnd = i + 1 == chunkCount ? end : begin + file.size() * (i + 1) / chunkCount;
+        chunkEnd = chunkEnd <= chunkBegin ? chunkBegin : nextLine(chunkEnd - 1, end);
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.parallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i) { countChunk(chunks[i]); });
+
+    ElementCounts total;
+    for (auto &chunk : chunks) {
+        chunk.offsets = total;
+        total.positions += chunk.counts.positions;
+        total.normals += chunk.counts.normals;
+        total.texcoords += chunk.counts.texcoords;
+        total.triangles += chunk.counts.triangles;
+    }
+    data.positions.resize(total.positions);
+    data.normals.resize(total.normals);
+    data.texcoords.resize(total.texcoords);
+    data.corners.resize(total.triangles * 3);
+
+    pool.parallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t i) { parseChunk(chunks[i], data); });
+
+    std::atomic<bool> valid = true;
+    const size_t cornersPerTask = 1 << 16;
+    pool.parallelFor(static_cast<uint32_t>((data.corners.size() + cornersPerTask - 1) / cornersPerTask), [&](uint32_t task) {
+        size_t last = std::min(data.corners.size(), (task + 1) * cornersPerTask);
+        for (size_t i = task * cornersPerTask; i < last; i++) {
+            const auto &corner = data.corners[i];
+            if (corner.position < 0 || corner.position >= static_cast<int32_t>(data.positions.size()) ||
+                corner.texcoord < -1 || corner.texcoord >= static_cast<int32_t>(data.texcoords.size()) ||
+                corner.normal < -1 || corner.normal >= static_cast<int32_t>(data.normals.size())) {
+                valid = false;
+                return;
+            }
+        }
+    });
+    return valid;
+}
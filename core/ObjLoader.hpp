@@ -0,0 +1,35 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_OBJLOADER_HPP
+#define VULKAN_EXPERIMENTS_OBJLOADER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+// zero-based indices of one face corner, -1 when the attribute is missing
+struct ObjIndex {
+    int32_t position = -1;
+    int32_t texcoord = -1;
+    int32_t normal = -1;
+};
+
+struct ObjData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;
+    // three corners per triangle, polygons are fan triangulated
+    std::vector<ObjIndex> corners;
+};
+
+// Parses the file through a memory mapping in line aligned chunks on the global thread pool.
+// The first pass counts elements per chunk so the second one writes straight into presized arrays.
+class ObjLoader {
+public:
+    static bool load(const char *path, ObjData &data);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_OBJLOADER_HPP
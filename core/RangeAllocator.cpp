@@ -0,0 +1,95 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <iterator>
+#include <stdexcept>
+#include "RangeAllocator.hpp"
+
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+    grow(capacity);
+}
+
+uint32_t RangeAllocator::allocate(uint32_t count) {
+    if (count == 0) {
+        return INVALID_OFFSET;
+    }
+    auto best = freeRangesBySize.lower_bound(count);
+    if (best == freeRangesBySize.end()) {
+        return INVALID_OFFSET;
+    }
+    uint32_t offset = best->second;
+    uint32_t freeCount = best->first;
+    removeFreeRange(freeRanges.find(offset));
+    if (freeCount > count) {
+        addFreeRange(offset + count, freeCount - count);
+    }
+    allocatedRanges[offset] = count;
+    used += count;
+    return offset;
+}
+
+void RangeAllocator::free(uint32_t offset) {
+    auto allocated = allocatedRanges.find(offset);
+    if (allocated == allocatedRanges.end()) {
+        throw std::runtime_error("Freeing a range that was not allocated");
+    }
+    uint32_t count = allocated->second;
+    allocatedRanges.erase(allocated);
+    used -= count;
+
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && next->first == offset + count) {
+        count += next->second;
+        removeFreeRange(next);
+    }
+    auto previous = freeRanges.lower_bound(offset);
+    if (previous != freeRanges.begin()) {
+        --previous;
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            count += previous->second;
+            removeFreeRange(previous);
+        }
+    }
+    addFreeRange(offset, count);
+}
+
+void RangeAllocator::grow(uint32_t newCapacity) {
+    if (newCapacity <= capacity) {
+        return;
+    }
+    uint32_t offset = capacity;
+    uint32_t count = newCapacity - capacity;
+    // the new units continue a free range that ends at the old capacity
+    if (!freeRanges.empty()) {
+        auto last = std::prev(freeRanges.end());
+        if (last->first + last->second == capacity) {
+            offset = last->first;
+            count += last->second;
+            removeFreeRange(last);
+        }
+    }
+    addFreeRange(offset, count);
+    capacity = newCapacity;
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const {
+    return freeRangesBySize.empty() ? 0 : std::prev(freeRangesBySize.end())->first;
+}
+
+void RangeAllocator::addFreeRange(uint32_t offset, uint32_t count) {
+    freeRanges[offset] = count;
+    freeRangesBySize.emplace(count, offset);
+}
+
+void RangeAllocator::removeFreeRange(std::map<uint32_t, uint32_t>::iterator range) {
+    auto sized = freeRangesBySize.equal_range(range->second);
+    for (auto it = sized.first; it != sized.second; ++it) {
+        if (it->second == range->first) {
+            freeRangesBySize.erase(it);
+            break;
+        }
+    }
+    freeRanges.erase(range);
+}
@@ -0,0 +1,42 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_RANGEALLOCATOR_HPP
+#define VULKAN_EXPERIMENTS_RANGEALLOCATOR_HPP
+
+#include <cstdint>
+#include <map>
+
+// Free-list sub-allocator of [0, capacity) in abstract units (vertices, indices, bytes). Best fit, neighbouring free
+// ranges are merged when a range is freed
+class RangeAllocator {
+public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    // offset of count free units, INVALID_OFFSET when no free range is large enough
+    uint32_t allocate(uint32_t count);
+    void free(uint32_t offset);
+    // append free units at the end, allocated offsets stay valid
+    void grow(uint32_t newCapacity);
+
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getUsed() const { return used; }
+    uint32_t getLargestFreeRange() const;
+
+private:
+    void addFreeRange(uint32_t offset, uint32_t count);
+    void removeFreeRange(std::map<uint32_t, uint32_t>::iterator range);
+
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+    // offset -> count for free and for allocated ranges, free ones are also indexed by count for the best fit
+    std::map<uint32_t, uint32_t> freeRanges;
+    std::multimap<uint32_t, uint32_t> freeRangesBySize;
+    std::map<uint32_t, uint32_t> allocatedRanges;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_RANGEALLOCATOR_HPP
@@ -8,6 +8,7 @@
 #include <vector>
 #include <string>
 #include "DescriptorBinding.hpp"
+#include "VertexLayout.hpp"
 
 enum class ShaderStage
 {
@@ -37,6 +38,13 @@ struct Shader {
     std::vector<ShaderStageInfo> stagesInfo;
     DescriptorBinding descriptorBinding;
     std::vector<Constant> constants;
+    // vertex buffer layout the vertex stage reads
+    VertexLayout vertexLayout = VertexLayout::STANDARD;
+    InstanceLayout instanceLayout = InstanceLayout::NONE;
+    // reads only the position stream and writes no color, for depth prepass and shadow pipelines
+    bool depthOnly = false;
+    // drawn as patches of this many control points for the tessellation stages, 0 draws triangle lists
+    uint32_t patchControlPoints = 0;
 };
 
 class ShaderLoader
@@ -0,0 +1,182 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "TerrainClipmap.hpp"
+
+namespace {
+
+int32_t floorDiv(int32_t value, int32_t divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+int32_t wrap(int32_t value, int32_t size) {
+    int32_t result = value % size;
+    return result < 0 ? result + size : result;
+}
+
+}
+
+glm::uvec2 getClipmapMeshSize(ClipmapMesh mesh, uint32_t textureSize) {
+    // a level covers textureSize - 2 quads: four blocks a side with a fixup of two quads in the middle
+    uint32_t blockSize = textureSize / 4 - 1;
+    switch (mesh) {
+        case ClipmapMesh::BLOCK:
+            return {blockSize, blockSize};
+        case ClipmapMesh::FIXUP_X:
+            return {2, blockSize};
+        case ClipmapMesh::FIXUP_Z:
+            return {blockSize, 2};
+        case ClipmapMesh::TRIM_X:
+            return {1, blockSize * 2 + 2};
+        case ClipmapMesh::TRIM_Z:
+            return {blockSize * 2 + 1, 1};
+        default:
+            return {blockSize * 2 + 2, blockSize * 2 + 2};
+    }
+}
+
+void ClipmapSelection::clear() {
+    for (auto &meshBlocks : blocks) {
+        meshBlocks.clear();
+    }
+}
+
+TerrainClipmap::TerrainClipmap(const Heightmap &heightmap, float texelSize, float heightScale, float baseHeight, uint32_t levelCount,
+                               uint32_t textureSize) : texelSize(texelSize), heightScale(heightScale), baseHeight(baseHeight),
+                                                       levelCount(levelCount), textureSize(textureSize) {
+    // coarser levels are filtered rather than point sampled from the full heightmap
+    levels.push_back(heightmap);
+    for (uint32_t level = 1; level < levelCount; level++) {
+        levels.push_back(levels.back().downsample());
+    }
+    origins.resize(levelCount);
+    texels.resize(size_t(levelCount) * textureSize * textureSize * 4);
+}
+
+void TerrainClipmap::invalidate() {
+    valid = false;
+}
+
+void TerrainClipmap::update(const glm::vec3 &cameraPosition, std::vector<ClipmapRegion> &regions) {
+    int32_t size = int32_t(textureSize);
+    int32_t halfQuads = (size - 2) / 2;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        float spacing = getTexelSize(level);
+        glm::ivec2 camera(int32_t(std::floor(cameraPosition.x / spacing)), int32_t(std::floor(cameraPosition.z / spacing)));
+        // origins are even, so that a level starts on a texel of the next coarser one and sits one quad off its center
+        // at most
+        glm::ivec2 origin(floorDiv(camera.x, 2) * 2 - (halfQuads - 1), floorDiv(camera.y, 2) * 2 - (halfQuads - 1));
+        glm::ivec2 delta = origin - origins[level];
+        if (!valid || std::abs(delta.x) >= size || std::abs(delta.y) >= size) {
+            writeTexels(level, origin, glm::ivec2(size), regions);
+        }
+        else {
+            // columns that came into view over the whole height of the window, then the rows
+            if (delta.x != 0) {
+                int32_t start = delta.x > 0 ? origins[level].x + size : origin.x;
+                writeTexels(level, glm::ivec2(start, origin.y), glm::ivec2(std::abs(delta.x), size), regions);
+            }
+            if (delta.y != 0) {
+                int32_t start = delta.y > 0 ? origins[level].y + size : origin.y;
+                writeTexels(level, glm::ivec2(origin.x, start), glm::ivec2(size, std::abs(delta.y)), regions);
+            }
+        }
+        origins[level] = origin;
+    }
+    valid = true;
+}
+
+void TerrainClipmap::writeTexels(uint32_t level, glm::ivec2 start, glm::ivec2 size, std::vector<ClipmapRegion> &regions) {
+    int32_t textureExtent = int32_t(textureSize);
+    glm::ivec2 wrapped(wrap(start.x, textureExtent), wrap(start.y, textureExtent));
+    // up to two pieces along each axis, the second one starting over at 0
+    int32_t widths[2] = {std::min(size.x, textureExtent - wrapped.x), 0};
+    int32_t heights[2] = {std::min(size.y, textureExtent - wrapped.y), 0};
+    widths[1] = size.x - widths[0];
+    heights[1] = size.y - heights[0];
+    for (int32_t pieceY = 0; pieceY < 2; pieceY++) {
+        for (int32_t pieceX = 0; pieceX < 2; pieceX++) {
+            if (widths[pieceX] == 0 || heights[pieceY] == 0) {
+                continue;
+            }
+            int32_t textureX = pieceX == 0 ? wrapped.x : 0;
+            int32_t textureY = pieceY == 0 ? wrapped.y : 0;
+            int32_t levelX = start.x + (pieceX == 0 ? 0 : widths[0]);
+            int32_t levelY = start.y + (pieceY == 0 ? 0 : heights[0]);
+            for (int32_t y = 0; y < heights[pieceY]; y++) {
+                for (int32_t x = 0; x < widths[pieceX]; x++) {
+                    packTexel(level, levelX + x, levelY + y, texels.data() + getTexelOffset(level, textureX + x, textureY + y));
+                }
+            }
+            regions.push_back({level, uint32_t(textureX), uint32_t(textureY), uint32_t(widths[pieceX]), uint32_t(heights[pieceY])});
+        }
+    }
+}
+
+void TerrainClipmap::packTexel(uint32_t level, int32_t x, int32_t y, uint8_t *texel) const {
+    const Heightmap &heightmap = levels[level];
+    int32_t size = int32_t(heightmap.getSize());
+    auto height = [&](int32_t offsetX, int32_t offsetY) {
+        return heightmap.getHeight(uint32_t(wrap(x + offsetX, size)), uint32_t(wrap(y + offsetY, size)));
+    };
+    // the heightmap repeats, so the differences wrap around its edges instead of clamping like Heightmap::getNormal
+    float scale = heightScale / (2.0f * getTexelSize(level));
+    glm::vec3 normal = glm::normalize(glm::vec3(-(height(1, 0) - height(-1, 0)) * scale, 1.0f, -(height(0, 1) - height(0, -1)) * scale));
+    uint16_t value = heightmap.getData()[size_t(wrap(y, size)) * size + wrap(x, size)];
+    texel[0] = uint8_t(value >> 8);
+    texel[1] = uint8_t(value & 0xff);
+    texel[2] = uint8_t(std::lround((normal.x * 0.5f + 0.5f) * 255.0f));
+    texel[3] = uint8_t(std::lround((normal.z * 0.5f + 0.5f) * 255.0f));
+}
+
+void TerrainClipmap::select(const Frustum &frustum, ClipmapSelection &selection) const {
+    selection.clear();
+    uint32_t blockSize = textureSize / 4 - 1;
+    int32_t halfQuads = int32_t(textureSize - 2) / 2;
+    // the outer tenth of a level blends into the next coarser one
+    float transitionQuads = float(textureSize - 2) / 10.0f;
+    const uint32_t blockStarts[4] = {0, blockSize, blockSize * 2 + 2, blockSize * 3 + 2};
+    for (uint32_t level = 0; level < levelCount; level++) {
+        float spacing = getTexelSize(level);
+        glm::ivec2 origin = origins[level];
+        glm::vec2 center = glm::vec2(origin + halfQuads) * spacing;
+        glm::vec4 morph(center, (float(halfQuads) - transitionQuads - 1.0f) * spacing, transitionQuads * spacing);
+        auto addBlock = [&](ClipmapMesh mesh, uint32_t x, uint32_t y) {
+            glm::uvec2 meshSize = getClipmapMeshSize(mesh, textureSize);
+            glm::vec2 start = glm::vec2(origin + glm::ivec2(x, y)) * spacing;
+            glm::vec2 end = start + glm::vec2(meshSize) * spacing;
+            glm::vec3 min(start.x, baseHeight, start.y);
+            glm::vec3 max(end.x, baseHeight + heightScale, end.y);
+            if (!frustum.intersectsBox((min + max) * 0.5f, (max - min) * 0.5f)) {
+                return;
+            }
+            selection.blocks[static_cast<uint32_t>(mesh)].push_back({glm::vec4(start, spacing, float(level)), morph});
+        };
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 4; x++) {
+                // the middle of a level is drawn by the level inside it, or by the center mesh on the finest one
+                if ((x == 1 || x == 2) && (y == 1 || y == 2)) {
+                    continue;
+                }
+                addBlock(ClipmapMesh::BLOCK, blockStarts[x], blockStarts[y]);
+            }
+        }
+        addBlock(ClipmapMesh::FIXUP_X, blockSize * 2, 0);
+        addBlock(ClipmapMesh::FIXUP_X, blockSize * 2, blockSize * 3 + 2);
+        addBlock(ClipmapMesh::FIXUP_Z, 0, blockSize * 2);
+        addBlock(ClipmapMesh::FIXUP_Z, blockSize * 3 + 2, blockSize * 2);
+        if (level == 0) {
+            addBlock(ClipmapMesh::CENTER, blockSize, blockSize);
+            continue;
+        }
+        // the finer level starts blockSize or blockSize + 1 quads in, the trim fills the quad it leaves on the other side
+        glm::ivec2 inner = origins[level - 1] / 2 - origin;
+        uint32_t trimX = inner.x == int32_t(blockSize) ? blockSize * 3 + 1 : blockSize;
+        uint32_t trimY = inner.y == int32_t(blockSize) ? blockSize * 3 + 1 : blockSize;
+        addBlock(ClipmapMesh::TRIM_X, trimX, blockSize);
+        addBlock(ClipmapMesh::TRIM_Z, trimX == blockSize ? blockSize + 1 : blockSize, trimY);
+    }
+}
@@ -0,0 +1,98 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TERRAINCLIPMAP_HPP
+#define VULKAN_EXPERIMENTS_TERRAINCLIPMAP_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Frustum.hpp"
+#include "Heightmap.hpp"
+#include "TerrainQuadtree.hpp"
+
+// Meshes the rings are built of, each one a Mesh::generateTerrainBlock of getClipmapMeshSize quads
+enum class ClipmapMesh : uint32_t {
+    // twelve a ring, sixteen on the finest level
+    BLOCK = 0,
+    // the two quads wide gaps between the blocks in the middle of each side
+    FIXUP_X,
+    FIXUP_Z,
+    // the L around the finer level, which is one quad off the center on either side
+    TRIM_X,
+    TRIM_Z,
+    // the inside of the finest level
+    CENTER,
+    COUNT,
+};
+
+constexpr uint32_t CLIPMAP_MESH_COUNT = static_cast<uint32_t>(ClipmapMesh::COUNT);
+
+// quads of mesh along x and z for levels of textureSize texels
+glm::uvec2 getClipmapMeshSize(ClipmapMesh mesh, uint32_t textureSize);
+
+// Rectangle of texels of one level that changed, in the coordinates of its texture layer
+struct ClipmapRegion {
+    uint32_t level;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Blocks to draw this frame by mesh. TerrainNode::node holds the world xz of the block, the texel spacing and the
+// level, TerrainNode::morph the xz center of the level and where its transition to the next level starts and how wide it is
+struct ClipmapSelection {
+    std::vector<TerrainNode> blocks[CLIPMAP_MESH_COUNT];
+
+    void clear();
+};
+
+// Geometry clipmap: nested square rings of the same number of texels around the camera, every level twice as coarse
+// as the one inside it. A level's heights live in one layer of an array texture that is addressed toroidally, the
+// texel at level coordinates (x, y) is always stored at (x, y) mod textureSize. When the camera moves only the rows and
+// columns that come into view are written, whatever the size of the world
+class TerrainClipmap {
+public:
+    TerrainClipmap() = default;
+    // the heightmap repeats in x and z with texels texelSize apart on the finest level, coarser levels read its
+    // downsampled copies. textureSize is a power of two
+    TerrainClipmap(const Heightmap &heightmap, float texelSize, float heightScale, float baseHeight, uint32_t levelCount,
+                   uint32_t textureSize = 256);
+
+    // recenter the levels on the camera, write the texels that came into view into getTexels() and append their regions
+    void update(const glm::vec3 &cameraPosition, std::vector<ClipmapRegion> &regions);
+    // write every texel again with the next update
+    void invalidate();
+    void select(const Frustum &frustum, ClipmapSelection &selection) const;
+
+    uint32_t getLevelCount() const { return levelCount; }
+    uint32_t getTextureSize() const { return textureSize; }
+    float getTexelSize(uint32_t level) const { return texelSize * float(1u << level); }
+    // RGBA8 texels packed like Heightmap::packTexels, one layer of textureSize x textureSize texels per level
+    const std::vector<uint8_t> &getTexels() const { return texels; }
+    const uint8_t *getTexel(uint32_t level, uint32_t x, uint32_t y) const { return texels.data() + getTexelOffset(level, x, y); }
+
+private:
+    std::vector<Heightmap> levels;
+    float texelSize = 1.0f;
+    float heightScale = 1.0f;
+    float baseHeight = 0.0f;
+    uint32_t levelCount = 0;
+    uint32_t textureSize = 0;
+    // level coordinates of the first texel of every level's window, which is textureSize texels wide
+    std::vector<glm::ivec2> origins;
+    bool valid = false;
+    std::vector<uint8_t> texels;
+
+    size_t getTexelOffset(uint32_t level, uint32_t x, uint32_t y) const {
+        return ((size_t(level) * textureSize + y) * textureSize + x) * 4;
+    }
+    // write the texels of a rectangle in level coordinates, split where it wraps around the texture
+    void writeTexels(uint32_t level, glm::ivec2 start, glm::ivec2 size, std::vector<ClipmapRegion> &regions);
+    void packTexel(uint32_t level, int32_t x, int32_t y, uint8_t *texel) const;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TERRAINCLIPMAP_HPP
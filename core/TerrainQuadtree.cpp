@@ -0,0 +1,142 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include "TerrainQuadtree.hpp"
+
+namespace {
+
+// the part of the morph range spent at full detail, the vertices move over the rest
+const float MORPH_START_RATIO = 0.7f;
+
+bool intersectsSphere(const Bounds &bounds, const glm::vec3 &center, float radius) {
+    glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+    glm::vec3 offset = closest - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+}
+
+void TerrainSelection::clear() {
+    nodes.clear();
+    for (auto &quadrant : quadrants) {
+        quadrant.clear();
+    }
+}
+
+size_t TerrainSelection::size() const {
+    size_t count = nodes.size();
+    for (const auto &quadrant : quadrants) {
+        count += quadrant.size();
+    }
+    return count;
+}
+
+TerrainQuadtree::TerrainQuadtree(const Heightmap &heightmap, const glm::vec3 &origin, float size, float heightScale, uint32_t lodCount,
+                                 float lodRangeScale) : origin(origin), size(size), heightScale(heightScale), lodCount(lodCount) {
+    lodRanges.resize(lodCount);
+    float leafSize = size / float(1u << (lodCount - 1));
+    for (uint32_t lod = 0; lod < lodCount; lod++) {
+        lodRanges[lod] = leafSize * lodRangeScale * float(1u << lod);
+    }
+
+    // leaves take the texels they cover including the border ones they share with their neighbours, the levels above
+    // merge the ranges of their children
+    heightRanges.resize(lodCount);
+    uint32_t leafCount = 1u << (lodCount - 1);
+    uint32_t mapSize = heightmap.getSize();
+    auto &leaves = heightRanges[lodCount - 1];
+    leaves.resize(size_t(leafCount) * leafCount);
+    for (uint32_t y = 0; y < leafCount; y++) {
+        uint32_t y0 = y * (mapSize - 1) / leafCount;
+        uint32_t y1 = (y + 1) * (mapSize - 1) / leafCount;
+        for (uint32_t x = 0; x < leafCount; x++) {
+            uint32_t x0 = x * (mapSize - 1) / leafCount;
+            uint32_t x1 = (x + 1) * (mapSize - 1) / leafCount;
+            glm::vec2 range(1.0f, 0.0f);
+            for (uint32_t texelY = y0; texelY <= y1; texelY++) {
+                for (uint32_t texelX = x0; texelX <= x1; texelX++) {
+                    float height = heightmap.getHeight(texelX, texelY);
+                    range.x = std::min(range.x, height);
+                    range.y = std::max(range.y, height);
+                }
+            }
+            leaves[size_t(y) * leafCount + x] = range;
+        }
+    }
+    for (uint32_t level = lodCount - 1; level > 0; level--) {
+        uint32_t count = 1u << (level - 1);
+        const auto &children = heightRanges[level];
+        auto &parents = heightRanges[level - 1];
+        parents.resize(size_t(count) * count);
+        for (uint32_t y = 0; y < count; y++) {
+            for (uint32_t x = 0; x < count; x++) {
+                glm::vec2 range(1.0f, 0.0f);
+                for (uint32_t child = 0; child < 4; child++) {
+                    const glm::vec2 &childRange = children[size_t(y * 2 + child / 2) * count * 2 + x * 2 + child % 2];
+                    range.x = std::min(range.x, childRange.x);
+                    range.y = std::max(range.y, childRange.y);
+                }
+                parents[size_t(y) * count + x] = range;
+            }
+        }
+    }
+}
+
+Bounds TerrainQuadtree::getNodeBounds(uint32_t level, uint32_t x, uint32_t y) const {
+    float nodeSize = size / float(1u << level);
+    const glm::vec2 &range = heightRanges[level][(size_t(y) << level) + x];
+    Bounds bounds;
+    bounds.min = origin + glm::vec3(float(x) * nodeSize, range.x * heightScale, float(y) * nodeSize);
+    bounds.max = origin + glm::vec3(float(x + 1) * nodeSize, range.y * heightScale, float(y + 1) * nodeSize);
+    return bounds;
+}
+
+TerrainNode TerrainQuadtree::createNode(uint32_t level, uint32_t x, uint32_t y) const {
+    uint32_t lod = lodCount - 1 - level;
+    float nodeSize = size / float(1u << level);
+    float rangeStart = lod > 0 ? lodRanges[lod - 1] : 0.0f;
+    float morphEnd = lodRanges[lod];
+    float morphStart = rangeStart + (morphEnd - rangeStart) * MORPH_START_RATIO;
+    return {glm::vec4(origin.x + float(x) * nodeSize, origin.z + float(y) * nodeSize, nodeSize, float(lod)),
+            glm::vec4(morphStart, morphEnd, 0.0f, 0.0f)};
+}
+
+void TerrainQuadtree::select(const Frustum &frustum, const glm::vec3 &cameraPosition, TerrainSelection &selection) const {
+    selection.clear();
+    if (lodCount > 0) {
+        selectNode(frustum, cameraPosition, 0, 0, 0, selection);
+    }
+}
+
+bool TerrainQuadtree::selectNode(const Frustum &frustum, const glm::vec3 &cameraPosition, uint32_t level, uint32_t x, uint32_t y,
+                                 TerrainSelection &selection) const {
+    uint32_t lod = lodCount - 1 - level;
+    Bounds bounds = getNodeBounds(level, x, y);
+    if (!intersectsSphere(bounds, cameraPosition, lodRanges[lod])) {
+        return false;
+    }
+    // out of view counts as handled, the parent must not draw it either
+    if (!frustum.intersectsBox(bounds.getCenter(), bounds.getHalfExtent())) {
+        return true;
+    }
+    if (lod == 0 || !intersectsSphere(bounds, cameraPosition, lodRanges[lod - 1])) {
+        selection.nodes.push_back(createNode(level, x, y));
+        return true;
+    }
+    bool childSelected[4];
+    for (uint32_t child = 0; child < 4; child++) {
+        childSelected[child] = selectNode(frustum, cameraPosition, level + 1, x * 2 + child % 2, y * 2 + child / 2, selection);
+    }
+    if (std::all_of(childSelected, childSelected + 4, [](bool selected) { return !selected; })) {
+        selection.nodes.push_back(createNode(level, x, y));
+        return true;
+    }
+    for (uint32_t child = 0; child < 4; child++) {
+        if (!childSelected[child]) {
+            selection.quadrants[child].push_back(createNode(level, x, y));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TERRAINQUADTREE_HPP
+#define VULKAN_EXPERIMENTS_TERRAINQUADTREE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+#include "Heightmap.hpp"
+
+// Per-instance data of one selected node, read by the terrain vertex shader from the instance stream
+struct TerrainNode {
+    // world xz of the node corner, its edge length and its lod, 0 being the finest
+    glm::vec4 node;
+    // distances from the camera where the vertices start and finish morphing into the next coarser lod
+    glm::vec4 morph;
+};
+static_assert(sizeof(TerrainNode) == 32);
+
+// Nodes picked for a frame. A node whose children are only partly in the range of the finer lod draws its other
+// quarters at its own lod, those go into the list of their quadrant and draw a quarter of the grid mesh
+struct TerrainSelection {
+    std::vector<TerrainNode> nodes;
+    std::vector<TerrainNode> quadrants[4];
+
+    void clear();
+    size_t size() const;
+};
+
+// Quadtree of chunked lod terrain nodes over a heightmap. Every node is drawn with the same grid mesh scaled to its
+// size, so the nodes a frame draws grow with the log of the terrain size instead of its area
+class TerrainQuadtree {
+public:
+    TerrainQuadtree() = default;
+    // the heightmap covers size x size world units from origin along x and z and is scaled to heightScale. Leaves are
+    // lodCount - 1 levels below the root, the finest lod reaches lodRangeScale leaf sizes from the camera and each
+    // coarser one twice as far
+    TerrainQuadtree(const Heightmap &heightmap, const glm::vec3 &origin, float size, float heightScale, uint32_t lodCount,
+                    float lodRangeScale = 3.0f);
+
+    // walk the tree from the root and pick the coarsest nodes whose lod range covers them
+    void select(const Frustum &frustum, const glm::vec3 &cameraPosition, TerrainSelection &selection) const;
+
+    uint32_t getLodCount() const { return lodCount; }
+    float getLodRange(uint32_t lod) const { return lodRanges[lod]; }
+    // box of a node at level, the root being level 0
+    Bounds getNodeBounds(uint32_t level, uint32_t x, uint32_t y) const;
+
+private:
+    glm::vec3 origin = glm::vec3(0.0f);
+    float size = 0.0f;
+    float heightScale = 0.0f;
+    uint32_t lodCount = 0;
+    std::vector<float> lodRanges;
+    // min and max height in [0, 1] of every node, one row major grid of 2^level x 2^level nodes per level
+    std::vector<std::vector<glm::vec2>> heightRanges;
+
+    // returns false when the node is out of the range of its lod, the parent covers its area then
+    bool selectNode(const Frustum &frustum, const glm::vec3 &cameraPosition, uint32_t level, uint32_t x, uint32_t y,
+                    TerrainSelection &selection) const;
+    TerrainNode createNode(uint32_t level, uint32_t x, uint32_t y) const;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TERRAINQUADTREE_HPP
@@ -0,0 +1,41 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+
+void Texture::loadTextureFromFile(const char *path) {
+    uint64_t sourceHash = TextureCache::hashSource(path);
+    std::string cachePath = TextureCache::getCachePath(path);
+    if ((mipmaps || TextureCompressor::isBlockCompressed(format)) && TextureCache::load(cachePath.c_str(), sourceHash, *this)) {
+        return;
+    }
+    // per thread, the backend loads textures on the workers
+    stbi_set_flip_vertically_on_load_thread(true);
+    data = stbi_load(path, &width, &height, &nrChannels, STBI_rgb_alpha);
+    if (data) {
+        if (mipmaps || TextureCompressor::isBlockCompressed(format)) {
+            // the cooked texels are uploaded as they are, without blits on the GPU
+            unsigned char *image = data;
+            TextureCooker::cook(*this);
+            stbi_image_free(image);
+            if (!TextureCache::write(cachePath.c_str(), *this, sourceHash)) {
+                std::cout << "Failed to write texture cache " << cachePath << std::endl;
+            }
+        }
+    }
+    else {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+}
+
+Texture Texture::getLevels(uint32_t firstLevel) const {
+    Texture levels = *this;
+    levels.width = std::max(width >> firstLevel, 1);
+    levels.height = std::max(height >> firstLevel, 1);
+    levels.mipLevels = mipLevels - firstLevel;
+    levels.data = data + TextureCooker::getMipChainSize(width, height, layers, firstLevel, format);
+    return levels;
+}
@@ -6,23 +6,20 @@
 #define VULKAN_EXPERIMENTS_TEXTURE_HPP
 
 #include <iostream>
+#include <memory>
+#include <vector>
+#include "glm/glm.hpp"
 #include "stb_image.h"
+#include "MappedFile.hpp"
+#include "TextureCooker.hpp"
 
 class Texture {
 
 public:
     Texture() = default;
     explicit Texture(const char *name) : name(name) {};
-    void loadTextureFromFile(const char *path) {
-        stbi_set_flip_vertically_on_load(true);
-        data = stbi_load(path, &width, &height, &nrChannels, STBI_rgb_alpha);
-        if (data) {
-
-        }
-        else {
-            std::cout << "Failed to load texture" << std::endl;
-        }
-    }
+    // load the image through the texture cache next to it, cooking it on the first load
+    void loadTextureFromFile(const char *path);
     ~Texture(){
         //delete data;
     }
@@ -30,6 +27,24 @@ public:
     const char *name;
     int width{}, height{}, nrChannels{};
     unsigned char *data = nullptr;
+    // color data is sampled as sRGB, data like heights and normals is read as it is
+    bool srgb = true;
+    // layers of an array texture, data holds them one after another
+    uint32_t layers = 1;
+    // the backend generates the full mip chain on upload, data fetched by texel keeps only the base level
+    bool mipmaps = true;
+    // levels in data, largest first with all layers of a level together. With one level and mipmaps the backend
+    // blits the rest of the chain
+    uint32_t mipLevels = 1;
+    // set before loading, the image is compressed to it when it is cooked
+    TextureFormat format = TextureFormat::RGBA8;
+    // owns data when it was cooked rather than loaded
+    std::shared_ptr<std::vector<uint8_t>> cookedData;
+    // holds data when it was mapped from the texture cache
+    std::shared_ptr<MappedFile> cookedFile;
+
+    // the levels of a mip chain from firstLevel on, sharing data with this texture
+    Texture getLevels(uint32_t firstLevel) const;
 
     // get pixel color
     glm::vec4 getPixelColor(int x, int y) const {
@@ -0,0 +1,94 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "TextureCache.hpp"
+#include "MeshCache.hpp"
+#include "Texture.hpp"
+
+std::string TextureCache::getCachePath(const char *sourcePath) {
+    return std::string(sourcePath) + ".texcache";
+}
+
+uint64_t TextureCache::hashSource(const char *sourcePath) {
+    // the same fingerprint as mesh sources
+    return MeshCache::hashSource(sourcePath);
+}
+
+bool TextureCache::write(const char *path, const Texture &texture, uint64_t sourceHash) {
+    if (sourceHash == 0 || !texture.cookedData || texture.mipLevels > TextureCacheHeader::MAX_LEVELS) {
+        return false;
+    }
+    TextureCacheHeader header;
+    header.sourceHash = sourceHash;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.srgb = texture.srgb ? 1 : 0;
+    header.width = uint32_t(texture.width);
+    header.height = uint32_t(texture.height);
+    header.channels = uint32_t(texture.nrChannels);
+    header.layers = texture.layers;
+    header.levelCount = texture.mipLevels;
+    for (uint32_t level = 0; level < header.levelCount; level++) {
+        header.levelOffsets[level] = sizeof(TextureCacheHeader) + TextureCooker::getMipChainSize(header.width, header.height, header.layers, level, texture.format);
+        header.levelSizes[level] = TextureCooker::getMipChainSize(header.width, header.height, header.layers, level + 1, texture.format) + sizeof(TextureCacheHeader) - header.levelOffsets[level];
+    }
+
+    // written aside and renamed so that an interrupted write never leaves a truncated cache behind
+    std::string tempPath = std::string(path) + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(texture.cookedData->data()), std::streamsize(texture.cookedData->size()));
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    return !error;
+}
+
+bool TextureCache::load(const char *path, uint64_t sourceHash, Texture &texture) {
+    if (sourceHash == 0) {
+        return false;
+    }
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(TextureCacheHeader)) {
+        return false;
+    }
+    TextureCacheHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != TextureCacheHeader::MAGIC || header.version != TextureCacheHeader::VERSION || header.sourceHash != sourceHash ||
+        header.format != static_cast<uint32_t>(texture.format) || header.srgb != (texture.srgb ? 1u : 0u) || header.layers != texture.layers ||
+        header.width == 0 || header.height == 0 || header.levelCount == 0 || header.levelCount > TextureCacheHeader::MAX_LEVELS) {
+        return false;
+    }
+    uint32_t levelCount = texture.mipmaps ? TextureCooker::getMipLevelCount(header.width, header.height) : 1;
+    if (header.levelCount != levelCount) {
+        return false;
+    }
+    // the backend copies the chain as one range, so the levels have to be where a packed chain puts them
+    for (uint32_t level = 0; level < levelCount; level++) {
+        uint64_t offset = sizeof(TextureCacheHeader) + TextureCooker::getMipChainSize(header.width, header.height, header.layers, level, texture.format);
+        uint64_t size = TextureCooker::getMipChainSize(header.width, header.height, header.layers, level + 1, texture.format) + sizeof(TextureCacheHeader) - offset;
+        if (header.levelOffsets[level] != offset || header.levelSizes[level] != size || offset + size > file->size()) {
+            return false;
+        }
+    }
+
+    texture.width = int(header.width);
+    texture.height = int(header.height);
+    texture.nrChannels = int(header.channels);
+    texture.mipLevels = levelCount;
+    texture.cookedData.reset();
+    // only ever read, the backend copies it into the staging buffer
+    texture.data = reinterpret_cast<unsigned char *>(const_cast<char *>(file->data() + header.levelOffsets[0]));
+    texture.cookedFile = std::move(file);
+    return true;
+}
@@ -0,0 +1,54 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TEXTURECACHE_HPP
+#define VULKAN_EXPERIMENTS_TEXTURECACHE_HPP
+
+#include <cstdint>
+#include <string>
+
+class Texture;
+
+// On-disk layout of a cooked texture, the levels follow the header largest first without gaps between them, so the
+// whole chain is copied into the staging buffer at once
+struct TextureCacheHeader {
+    static constexpr uint32_t MAGIC = 0x58545856; // "VXTX"
+    static constexpr uint32_t VERSION = 1;
+    // enough for 65536 texels on a side
+    static constexpr uint32_t MAX_LEVELS = 17;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint64_t sourceHash = 0;
+    // TextureFormat of the texels
+    uint32_t format = 0;
+    uint32_t srgb = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // channels of the source image, the texels always have four
+    uint32_t channels = 0;
+    uint32_t layers = 0;
+    uint32_t levelCount = 0;
+    uint32_t reserved = 0;
+    // every layer of a level is in its range, one after another
+    uint64_t levelOffsets[MAX_LEVELS] = {};
+    uint64_t levelSizes[MAX_LEVELS] = {};
+};
+
+// Binary texture container written next to the source image after the first cook and memory-mapped afterwards, so a
+// warm start decodes no images
+class TextureCache {
+public:
+    static std::string getCachePath(const char *sourcePath);
+    // cheap fingerprint of the source file from its size and modification time
+    static uint64_t hashSource(const char *sourcePath);
+    // texture has to be cooked
+    static bool write(const char *path, const Texture &texture, uint64_t sourceHash);
+    // maps the cache into texture, fails when it is missing, stale, from another version or cooked with another format,
+    // color space or without the mipmaps texture asks for
+    static bool load(const char *path, uint64_t sourceHash, Texture &texture);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TEXTURECACHE_HPP
@@ -0,0 +1,447 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "TextureCompressor.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+const uint32_t BLOCK_SIZE = 4;
+const uint32_t BLOCK_TEXELS = BLOCK_SIZE * BLOCK_SIZE;
+// block rows of an image a task encodes
+const uint32_t BAND_BLOCK_ROWS = 4;
+const uint32_t AXIS_ITERATIONS = 8;
+const uint32_t REFINE_ITERATIONS = 2;
+// interpolation weights of the 4-bit indices of BC7, out of 64
+const int32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Block {
+    float texels[BLOCK_TEXELS][4];
+};
+
+size_t getBlockBytes(TextureFormat format) {
+    return format == TextureFormat::BC1 ? 8 : 16;
+}
+
+// texels past the edges of the image repeat its last row and column
+Block loadBlock(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY) {
+    Block block;
+    for (uint32_t y = 0; y < BLOCK_SIZE; y++) {
+        uint32_t row = std::min(blockY * BLOCK_SIZE + y, height - 1);
+        for (uint32_t x = 0; x < BLOCK_SIZE; x++) {
+            uint32_t column = std::min(blockX * BLOCK_SIZE + x, width - 1);
+            const uint8_t *texel = texels + (size_t(row) * width + column) * 4;
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                block.texels[y * BLOCK_SIZE + x][channel] = float(texel[channel]);
+            }
+        }
+    }
+    return block;
+}
+
+// the direction the first channels of the block vary most along, by power iteration on their covariance
+void findAxis(const Block &block, uint32_t channels, float mean[4], float axis[4]) {
+    float minimum[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+    float maximum[4] = {};
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        mean[channel] = 0.0f;
+        axis[channel] = 0.0f;
+    }
+    for (const auto &texel : block.texels) {
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            mean[channel] += texel[channel] / float(BLOCK_TEXELS);
+            minimum[channel] = std::min(minimum[channel], texel[channel]);
+            maximum[channel] = std::max(maximum[channel], texel[channel]);
+        }
+    }
+    float covariance[4][4] = {};
+    for (const auto &texel : block.texels) {
+        for (uint32_t i = 0; i < channels; i++) {
+            for (uint32_t j = 0; j < channels; j++) {
+                covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+    }
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        axis[channel] = maximum[channel] - minimum[channel];
+    }
+    for (uint32_t iteration = 0; iteration < AXIS_ITERATIONS; iteration++) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (uint32_t i = 0; i < channels; i++) {
+            for (uint32_t j = 0; j < channels; j++) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            length = std::max(length, std::abs(next[i]));
+        }
+        if (length < 1e-6f) {
+            break;
+        }
+        for (uint32_t i = 0; i < channels; i++) {
+            axis[i] = next[i] / length;
+        }
+    }
+}
+
+// the texels at both ends of the block along its axis
+void findEndpoints(const Block &block, uint32_t channels, float start[4], float end[4]) {
+    float mean[4];
+    float axis[4];
+    findAxis(block, channels, mean, axis);
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    uint32_t minimumTexel = 0;
+    uint32_t maximumTexel = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float projection = 0.0f;
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            projection += (block.texels[i][channel] - mean[channel]) * axis[channel];
+        }
+        if (i == 0 || projection < minimum) {
+            minimum = projection;
+            minimumTexel = i;
+        }
+        if (i == 0 || projection > maximum) {
+            maximum = projection;
+            maximumTexel = i;
+        }
+    }
+    std::memcpy(start, block.texels[maximumTexel], sizeof(float) * 4);
+    std::memcpy(end, block.texels[minimumTexel], sizeof(float) * 4);
+}
+
+// endpoints that fit the texels best in the least squares sense for fixed weights of the start endpoint
+bool fitEndpoints(const Block &block, uint32_t channels, const float weights[BLOCK_TEXELS], float start[4], float end[4]) {
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax[4] = {};
+    float bx[4] = {};
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float a = weights[i];
+        float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            ax[channel] += a * block.texels[i][channel];
+            bx[channel] += b * block.texels[i][channel];
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        start[channel] = std::clamp((ax[channel] * bb - bx[channel] * ab) / determinant, 0.0f, 255.0f);
+        end[channel] = std::clamp((bx[channel] * aa - ax[channel] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+struct BitWriter {
+    uint8_t *bytes;
+    uint32_t position = 0;
+
+    void write(uint32_t value, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++, position++) {
+            bytes[position / 8] |= uint8_t(((value >> i) & 1u) << (position % 8));
+        }
+    }
+};
+
+uint16_t packRgb565(const float color[4]) {
+    auto r = uint32_t(std::clamp(std::lround(color[0] * 31.0f / 255.0f), 0L, 31L));
+    auto g = uint32_t(std::clamp(std::lround(color[1] * 63.0f / 255.0f), 0L, 63L));
+    auto b = uint32_t(std::clamp(std::lround(color[2] * 31.0f / 255.0f), 0L, 31L));
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+void unpackRgb565(uint16_t packed, float color[3]) {
+    uint32_t r = packed >> 11;
+    uint32_t g = (packed >> 5) & 63u;
+    uint32_t b = packed & 31u;
+    color[0] = float((r << 3) | (r >> 2));
+    color[1] = float((g << 2) | (g >> 4));
+    color[2] = float((b << 3) | (b >> 2));
+}
+
+// weight of the first endpoint for each BC1 index in four color mode
+const float BC1_WEIGHTS[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+float selectColorIndices(const Block &block, uint16_t start, uint16_t end, uint8_t indices[BLOCK_TEXELS]) {
+    float palette[4][3];
+    unpackRgb565(start, palette[0]);
+    unpackRgb565(end, palette[1]);
+    for (uint32_t channel = 0; channel < 3; channel++) {
+        palette[2][channel] = (2.0f * palette[0][channel] + palette[1][channel]) / 3.0f;
+        palette[3][channel] = (palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f;
+    }
+    float error = 0.0f;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float bestError = 0.0f;
+        for (uint8_t index = 0; index < 4; index++) {
+            float texelError = 0.0f;
+            for (uint32_t channel = 0; channel < 3; channel++) {
+                float difference = palette[index][channel] - block.texels[i][channel];
+                texelError += difference * difference;
+            }
+            if (index == 0 || texelError < bestError) {
+                bestError = texelError;
+                indices[i] = index;
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+// BC1 layout, always in four color mode so BC3 decodes it the same way
+void encodeColorBlock(const Block &block, uint8_t *result) {
+    float start[4];
+    float end[4];
+    findEndpoints(block, 3, start, end);
+    uint16_t bestStart = packRgb565(start);
+    uint16_t bestEnd = packRgb565(end);
+    uint8_t bestIndices[BLOCK_TEXELS];
+    float bestError = selectColorIndices(block, bestStart, bestEnd, bestIndices);
+    for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; iteration++) {
+        float weights[BLOCK_TEXELS];
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            weights[i] = BC1_WEIGHTS[bestIndices[i]];
+        }
+        if (!fitEndpoints(block, 3, weights, start, end)) {
+            break;
+        }
+        uint16_t packedStart = packRgb565(start);
+        uint16_t packedEnd = packRgb565(end);
+        uint8_t indices[BLOCK_TEXELS];
+        float error = selectColorIndices(block, packedStart, packedEnd, indices);
+        if (error >= bestError) {
+            break;
+        }
+        bestStart = packedStart;
+        bestEnd = packedEnd;
+        bestError = error;
+        std::memcpy(bestIndices, indices, sizeof(indices));
+    }
+    // the larger endpoint goes first for four colors, swapping them swaps index 0 with 1 and 2 with 3
+    if (bestStart < bestEnd) {
+        std::swap(bestStart, bestEnd);
+        for (auto &index : bestIndices) {
+            index ^= 1;
+        }
+    }
+    else if (bestStart == bestEnd) {
+        std::fill(std::begin(bestIndices), std::end(bestIndices), 0);
+    }
+    std::memset(result, 0, 8);
+    result[0] = uint8_t(bestStart);
+    result[1] = uint8_t(bestStart >> 8);
+    result[2] = uint8_t(bestEnd);
+    result[3] = uint8_t(bestEnd >> 8);
+    BitWriter writer{result + 4};
+    for (uint8_t index : bestIndices) {
+        writer.write(index, 2);
+    }
+}
+
+// BC4 layout for one channel, in the mode with six values between the endpoints
+void encodeChannelBlock(const Block &block, uint32_t channel, uint8_t *result) {
+    float minimum = 255.0f;
+    float maximum = 0.0f;
+    for (const auto &texel : block.texels) {
+        minimum = std::min(minimum, texel[channel]);
+        maximum = std::max(maximum, texel[channel]);
+    }
+    std::memset(result, 0, 8);
+    result[0] = uint8_t(maximum);
+    result[1] = uint8_t(minimum);
+    if (result[0] == result[1]) {
+        return;
+    }
+    BitWriter writer{result + 2};
+    float scale = 7.0f / (float(result[0]) - float(result[1]));
+    for (const auto &texel : block.texels) {
+        // steps from the first endpoint to the second, the endpoints themselves are indices 0 and 1
+        auto step = uint32_t(std::lround((float(result[0]) - texel[channel]) * scale));
+        writer.write(step == 0 ? 0 : step == 7 ? 1 : step + 1, 3);
+    }
+}
+
+struct Bc7Endpoints {
+    int32_t start[4];
+    int32_t end[4];
+    uint32_t quantizedStart[4];
+    uint32_t quantizedEnd[4];
+    uint32_t startBit;
+    uint32_t endBit;
+};
+
+// 7 bits per channel and a bit shared by the channels of each endpoint
+Bc7Endpoints quantizeBc7Endpoints(const float start[4], const float end[4], uint32_t startBit, uint32_t endBit) {
+    Bc7Endpoints endpoints{};
+    endpoints.startBit = startBit;
+    endpoints.endBit = endBit;
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        endpoints.quantizedStart[channel] = uint32_t(std::clamp(std::lround((start[channel] - float(startBit)) / 2.0f), 0L, 127L));
+        endpoints.quantizedEnd[channel] = uint32_t(std::clamp(std::lround((end[channel] - float(endBit)) / 2.0f), 0L, 127L));
+        endpoints.start[channel] = int32_t((endpoints.quantizedStart[channel] << 1) | startBit);
+        endpoints.end[channel] = int32_t((endpoints.quantizedEnd[channel] << 1) | endBit);
+    }
+    return endpoints;
+}
+
+// the palette lies on a line, so the index is found by projecting onto it and checking the neighbours
+float selectBc7Indices(const Block &block, const Bc7Endpoints &endpoints, uint8_t indices[BLOCK_TEXELS]) {
+    int32_t palette[16][4];
+    for (uint32_t index = 0; index < 16; index++) {
+        for (uint32_t channel = 0; channel < 4; channel++) {
+            palette[index][channel] = ((64 - BC7_WEIGHTS[index]) * endpoints.start[channel] + BC7_WEIGHTS[index] * endpoints.end[channel] + 32) >> 6;
+        }
+    }
+    float direction[4];
+    float lengthSquared = 0.0f;
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        direction[channel] = float(endpoints.end[channel] - endpoints.start[channel]);
+        lengthSquared += direction[channel] * direction[channel];
+    }
+    float error = 0.0f;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        int32_t estimate = 0;
+        if (lengthSquared > 0.0f) {
+            float projection = 0.0f;
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                projection += (block.texels[i][channel] - float(endpoints.start[channel])) * direction[channel];
+            }
+            estimate = int32_t(std::clamp(std::lround(projection / lengthSquared * 15.0f), 0L, 15L));
+        }
+        float bestError = -1.0f;
+        for (int32_t index = std::max(estimate - 1, 0); index <= std::min(estimate + 1, 15); index++) {
+            float texelError = 0.0f;
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                float difference = float(palette[index][channel]) - block.texels[i][channel];
+                texelError += difference * difference;
+            }
+            if (bestError < 0.0f || texelError < bestError) {
+                bestError = texelError;
+                indices[i] = uint8_t(index);
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+// mode 6 only, one subset with RGBA endpoints and 4-bit indices
+void encodeBc7Block(const Block &block, uint8_t *result) {
+    float start[4];
+    float end[4];
+    findEndpoints(block, 4, start, end);
+    Bc7Endpoints best{};
+    uint8_t bestIndices[BLOCK_TEXELS];
+    float bestError = -1.0f;
+    for (uint32_t iteration = 0; iteration <= REFINE_ITERATIONS; iteration++) {
+        if (iteration > 0) {
+            float weights[BLOCK_TEXELS];
+            for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+                weights[i] = float(64 - BC7_WEIGHTS[bestIndices[i]]) / 64.0f;
+            }
+            if (!fitEndpoints(block, 4, weights, start, end)) {
+                break;
+            }
+        }
+        float previousError = bestError;
+        for (uint32_t bits = 0; bits < 4; bits++) {
+            auto endpoints = quantizeBc7Endpoints(start, end, bits & 1u, bits >> 1);
+            uint8_t indices[BLOCK_TEXELS];
+            float error = selectBc7Indices(block, endpoints, indices);
+            if (bestError < 0.0f || error < bestError) {
+                best = endpoints;
+                bestError = error;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+        if (bestError == 0.0f || bestError == previousError) {
+            break;
+        }
+    }
+    // the top bit of the first index is implied to be zero
+    if (bestIndices[0] & 8) {
+        std::swap(best.quantizedStart, best.quantizedEnd);
+        std::swap(best.startBit, best.endBit);
+        for (auto &index : bestIndices) {
+            index = uint8_t(15 - index);
+        }
+    }
+    std::memset(result, 0, 16);
+    BitWriter writer{result};
+    writer.write(1u << 6, 7);
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        writer.write(best.quantizedStart[channel], 7);
+        writer.write(best.quantizedEnd[channel], 7);
+    }
+    writer.write(best.startBit, 1);
+    writer.write(best.endBit, 1);
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        writer.write(bestIndices[i], i == 0 ? 3 : 4);
+    }
+}
+
+void encodeBlock(const Block &block, TextureFormat format, uint8_t *result) {
+    switch (format) {
+        case TextureFormat::BC1:
+            encodeColorBlock(block, result);
+            break;
+        case TextureFormat::BC3:
+            encodeChannelBlock(block, 3, result);
+            encodeColorBlock(block, result + 8);
+            break;
+        case TextureFormat::BC5:
+            encodeChannelBlock(block, 0, result);
+            encodeChannelBlock(block, 1, result + 8);
+            break;
+        case TextureFormat::BC7:
+            encodeBc7Block(block, result);
+            break;
+        case TextureFormat::RGBA8:
+            break;
+    }
+}
+
+}
+
+size_t TextureCompressor::getImageSize(uint32_t width, uint32_t height, TextureFormat format) {
+    if (!isBlockCompressed(format)) {
+        return size_t(width) * height * 4;
+    }
+    size_t blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return blocksX * blocksY * getBlockBytes(format);
+}
+
+std::vector<uint8_t> TextureCompressor::compress(const uint8_t *texels, uint32_t width, uint32_t height, TextureFormat format) {
+    std::vector<uint8_t> blocks(getImageSize(width, height, format));
+    if (!isBlockCompressed(format)) {
+        std::memcpy(blocks.data(), texels, blocks.size());
+        return blocks;
+    }
+    uint32_t blocksX = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t blocksY = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t blockBytes = getBlockBytes(format);
+    uint32_t bandCount = (blocksY + BAND_BLOCK_ROWS - 1) / BAND_BLOCK_ROWS;
+    ThreadPool::global().parallelFor(bandCount, [&](uint32_t band) {
+        uint32_t lastRow = std::min((band + 1) * BAND_BLOCK_ROWS, blocksY);
+        for (uint32_t blockY = band * BAND_BLOCK_ROWS; blockY < lastRow; blockY++) {
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+                auto block = loadBlock(texels, width, height, blockX, blockY);
+                encodeBlock(block, format, blocks.data() + (size_t(blockY) * blocksX + blockX) * blockBytes);
+            }
+        }
+    });
+    return blocks;
+}
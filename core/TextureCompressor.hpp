@@ -0,0 +1,38 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TEXTURECOMPRESSOR_HPP
+#define VULKAN_EXPERIMENTS_TEXTURECOMPRESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TextureFormat : uint32_t {
+    RGBA8,
+    // opaque color, 8 bytes per 4x4 block
+    BC1,
+    // color and alpha, 16 bytes per block
+    BC3,
+    // two channels like normals or masks, red and green of the source, never sRGB
+    BC5,
+    // color and alpha at higher quality than BC3, 16 bytes per block
+    BC7,
+};
+
+// Encodes RGBA8 images to block compressed formats, the block rows of an image are split between the threads of
+// the global pool
+class TextureCompressor {
+public:
+    static bool isBlockCompressed(TextureFormat format) { return format != TextureFormat::RGBA8; }
+    // bytes of a width x height image, partial blocks at the edges take a whole block
+    static size_t getImageSize(uint32_t width, uint32_t height, TextureFormat format);
+
+    // texels is one RGBA8 image. Colors are fitted as they are stored, BCn interpolates sRGB endpoints before decoding
+    // them, so sRGB images are compressed the same way
+    static std::vector<uint8_t> compress(const uint8_t *texels, uint32_t width, uint32_t height, TextureFormat format);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TEXTURECOMPRESSOR_HPP
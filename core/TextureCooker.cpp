@@ -0,0 +1,336 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "TextureCooker.hpp"
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COOKER_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COOKER_USE_SSE
+#endif
+
+namespace {
+
+// rows of the smaller level a task filters, the rows of the larger level under them are decoded once per task
+const uint32_t BAND_ROWS = 8;
+const float KAISER_WIDTH = 3.0f;
+const float KAISER_ALPHA = 4.0f;
+const uint32_t COARSE_SRGB_SIZE = 4096;
+const float PI = 3.14159265358979f;
+
+struct ColorTables {
+    // byte to linear value, sRGB bytes first and then bytes that are stored linear
+    float toLinear[512];
+    // linear value halfway between each sRGB byte and the next one
+    float srgbThresholds[256];
+    // first sRGB byte a linear value in each bucket can round to
+    uint8_t coarseSrgb[COARSE_SRGB_SIZE];
+};
+
+double srgbToLinear(double value) {
+    return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+const ColorTables &getColorTables() {
+    static const ColorTables tables = []() {
+        ColorTables result{};
+        for (uint32_t i = 0; i < 256; i++) {
+            result.toLinear[i] = float(srgbToLinear(i / 255.0));
+            result.toLinear[256 + i] = i / 255.0f;
+            result.srgbThresholds[i] = i < 255 ? float(srgbToLinear((i + 0.5) / 255.0)) : 2.0f;
+        }
+        uint32_t byte = 0;
+        for (uint32_t i = 0; i < COARSE_SRGB_SIZE; i++) {
+            float bucketStart = float(i) / float(COARSE_SRGB_SIZE - 1);
+            while (result.srgbThresholds[byte] < bucketStart) {
+                byte++;
+            }
+            result.coarseSrgb[i] = uint8_t(byte);
+        }
+        return result;
+    }();
+    return tables;
+}
+
+inline uint8_t encodeSrgb(const ColorTables &tables, float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    uint32_t byte = tables.coarseSrgb[uint32_t(value * float(COARSE_SRGB_SIZE - 1))];
+    while (value > tables.srgbThresholds[byte]) {
+        byte++;
+    }
+    return uint8_t(byte);
+}
+
+inline uint8_t encodeLinear(float value) {
+    return uint8_t(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (uint32_t k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// distance is in texels of the smaller level
+double kaiserWeight(double distance) {
+    if (std::abs(distance) >= KAISER_WIDTH) {
+        return 0.0;
+    }
+    double sinc = distance == 0.0 ? 1.0 : std::sin(PI * distance) / (PI * distance);
+    double window = distance / KAISER_WIDTH;
+    return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - window * window)) / besselI0(KAISER_ALPHA);
+}
+
+// the same number of taps for every texel of the smaller level, taps past the edge are clamped to it
+struct FilterTaps {
+    uint32_t count = 0;
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
+FilterTaps buildTaps(uint32_t sourceSize, uint32_t size, MipFilter filter) {
+    double scale = double(sourceSize) / double(size);
+    double radius = filter == MipFilter::BOX ? scale * 0.5 : KAISER_WIDTH * scale;
+    std::vector<std::vector<std::pair<int64_t, double>>> texelTaps(size);
+    FilterTaps taps;
+    for (uint32_t i = 0; i < size; i++) {
+        double center = (i + 0.5) * scale;
+        double weightSum = 0.0;
+        for (auto source = int64_t(std::floor(center - radius)); double(source) < center + radius; source++) {
+            double weight;
+            if (filter == MipFilter::BOX) {
+                weight = std::min(double(source + 1), center + radius) - std::max(double(source), center - radius);
+            }
+            else {
+                weight = kaiserWeight((source + 0.5 - center) / scale);
+            }
+            if (weight != 0.0) {
+                texelTaps[i].emplace_back(source, weight);
+                weightSum += weight;
+            }
+        }
+        for (auto &tap : texelTaps[i]) {
+            tap.second /= weightSum;
+        }
+        taps.count = std::max(taps.count, uint32_t(texelTaps[i].size()));
+    }
+    taps.indices.resize(size_t(size) * taps.count);
+    taps.weights.resize(size_t(size) * taps.count, 0.0f);
+    for (uint32_t i = 0; i < size; i++) {
+        for (uint32_t k = 0; k < taps.count; k++) {
+            size_t tap = size_t(i) * taps.count + k;
+            if (k < texelTaps[i].size()) {
+                taps.indices[tap] = uint32_t(std::clamp<int64_t>(texelTaps[i][k].first, 0, int64_t(sourceSize) - 1));
+                taps.weights[tap] = float(texelTaps[i][k].second);
+            }
+            else {
+                taps.indices[tap] = taps.indices[tap - 1];
+            }
+        }
+    }
+    return taps;
+}
+
+void decodeRow(const ColorTables &tables, const uint8_t *bytes, size_t count, bool srgb, float *values) {
+    // alpha is never sRGB encoded
+    uint32_t colorTable = srgb ? 0 : 256;
+    size_t i = 0;
+#if defined(COOKER_USE_AVX2)
+    __m256i tableOffsets = _mm256_setr_epi32(int(colorTable), int(colorTable), int(colorTable), 256, int(colorTable), int(colorTable), int(colorTable), 256);
+    for (; i + 8 <= count; i += 8) {
+        __m256i indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(bytes + i))), tableOffsets);
+        _mm256_storeu_ps(values + i, _mm256_i32gather_ps(tables.toLinear, indices, 4));
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] = tables.toLinear[bytes[i] + ((i & 3) == 3 ? 256 : colorTable)];
+    }
+}
+
+// values = sum of weights[k] * rows[k], the rows are count floats long
+void combineRows(const float *const *rows, const float *weights, uint32_t rowCount, size_t count, float *values) {
+    size_t i = 0;
+#if defined(COOKER_USE_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + i));
+        for (uint32_t k = 1; k < rowCount; k++) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        }
+        _mm256_storeu_ps(values + i, sum);
+    }
+#elif defined(COOKER_USE_SSE)
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+        for (uint32_t k = 1; k < rowCount; k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        }
+        _mm_storeu_ps(values + i, sum);
+    }
+#endif
+    for (; i < count; i++) {
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < rowCount; k++) {
+            sum += weights[k] * rows[k][i];
+        }
+        values[i] = sum;
+    }
+}
+
+// filters a row across, four floats per texel, and encodes it back to bytes
+void filterRow(const ColorTables &tables, const float *row, const FilterTaps &taps, uint32_t width, bool srgb, uint8_t *texels) {
+    for (uint32_t x = 0; x < width; x++) {
+        const uint32_t *indices = taps.indices.data() + size_t(x) * taps.count;
+        const float *weights = taps.weights.data() + size_t(x) * taps.count;
+        alignas(16) float texel[4];
+#if defined(COOKER_USE_AVX2) || defined(COOKER_USE_SSE)
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps.count; k++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + size_t(indices[k]) * 4)));
+        }
+        _mm_store_ps(texel, sum);
+#else
+        texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+        for (uint32_t k = 0; k < taps.count; k++) {
+            for (uint32_t channel = 0; channel < 4; channel++) {
+                texel[channel] += weights[k] * row[size_t(indices[k]) * 4 + channel];
+            }
+        }
+#endif
+        uint8_t *result = texels + size_t(x) * 4;
+        for (uint32_t channel = 0; channel < 3; channel++) {
+            result[channel] = srgb ? encodeSrgb(tables, texel[channel]) : encodeLinear(texel[channel]);
+        }
+        result[3] = encodeLinear(texel[3]);
+    }
+}
+
+struct LevelFilter {
+    uint32_t sourceWidth;
+    uint32_t sourceHeight;
+    uint32_t width;
+    uint32_t height;
+    FilterTaps tapsX;
+    FilterTaps tapsY;
+    bool srgb;
+};
+
+void filterBand(const ColorTables &tables, const LevelFilter &level, const uint8_t *source, uint8_t *texels, uint32_t firstRow, uint32_t lastRow) {
+    // the source rows under the band, decoded once
+    uint32_t firstSource = level.tapsY.indices[size_t(firstRow) * level.tapsY.count];
+    uint32_t lastSource = firstSource;
+    for (size_t tap = size_t(firstRow) * level.tapsY.count; tap < size_t(lastRow) * level.tapsY.count; tap++) {
+        firstSource = std::min(firstSource, level.tapsY.indices[tap]);
+        lastSource = std::max(lastSource, level.tapsY.indices[tap]);
+    }
+    size_t rowFloats = size_t(level.sourceWidth) * 4;
+    thread_local std::vector<float> decoded;
+    thread_local std::vector<float> combined;
+    thread_local std::vector<const float *> rows;
+    decoded.resize(rowFloats * (lastSource - firstSource + 1));
+    combined.resize(rowFloats);
+    rows.resize(level.tapsY.count);
+    for (uint32_t y = firstSource; y <= lastSource; y++) {
+        decodeRow(tables, source + size_t(y) * rowFloats, rowFloats, level.srgb, decoded.data() + (y - firstSource) * rowFloats);
+    }
+    for (uint32_t y = firstRow; y < lastRow; y++) {
+        for (uint32_t k = 0; k < level.tapsY.count; k++) {
+            rows[k] = decoded.data() + (level.tapsY.indices[size_t(y) * level.tapsY.count + k] - firstSource) * rowFloats;
+        }
+        combineRows(rows.data(), level.tapsY.weights.data() + size_t(y) * level.tapsY.count, level.tapsY.count, rowFloats, combined.data());
+        filterRow(tables, combined.data(), level.tapsX, level.width, level.srgb, texels + size_t(y) * level.width * 4);
+    }
+}
+
+}
+
+uint32_t TextureCooker::getMipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+size_t TextureCooker::getMipChainSize(uint32_t width, uint32_t height, uint32_t layers, uint32_t levels, TextureFormat format) {
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; level++) {
+        size += TextureCompressor::getImageSize(std::max(width >> level, 1u), std::max(height >> level, 1u), format) * layers;
+    }
+    return size;
+}
+
+void TextureCooker::cook(Texture &texture) {
+    auto width = uint32_t(texture.width);
+    auto height = uint32_t(texture.height);
+    uint32_t levels = texture.mipmaps ? getMipLevelCount(width, height) : 1;
+    std::vector<uint8_t> chain;
+    if (levels > 1) {
+        chain = buildMipChain(texture.data, width, height, texture.layers, texture.srgb);
+    }
+    else {
+        chain.assign(texture.data, texture.data + getMipChainSize(width, height, texture.layers, 1));
+    }
+    if (TextureCompressor::isBlockCompressed(texture.format)) {
+        std::vector<uint8_t> blocks;
+        blocks.reserve(getMipChainSize(width, height, texture.layers, levels, texture.format));
+        const uint8_t *texels = chain.data();
+        for (uint32_t level = 0; level < levels; level++) {
+            uint32_t levelWidth = std::max(width >> level, 1u);
+            uint32_t levelHeight = std::max(height >> level, 1u);
+            for (uint32_t layer = 0; layer < texture.layers; layer++) {
+                auto layerBlocks = TextureCompressor::compress(texels, levelWidth, levelHeight, texture.format);
+                blocks.insert(blocks.end(), layerBlocks.begin(), layerBlocks.end());
+                texels += size_t(levelWidth) * levelHeight * 4;
+            }
+        }
+        chain = std::move(blocks);
+    }
+    texture.cookedData = std::make_shared<std::vector<uint8_t>>(std::move(chain));
+    texture.data = texture.cookedData->data();
+    texture.mipLevels = levels;
+}
+
+std::vector<uint8_t> TextureCooker::buildMipChain(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t layers, bool srgb, MipFilter filter) {
+    const auto &tables = getColorTables();
+    uint32_t levelCount = getMipLevelCount(width, height);
+    std::vector<uint8_t> chain(getMipChainSize(width, height, layers, levelCount));
+    std::memcpy(chain.data(), texels, getMipChainSize(width, height, layers, 1));
+
+    size_t sourceOffset = 0;
+    for (uint32_t level = 1; level < levelCount; level++) {
+        LevelFilter levelFilter;
+        levelFilter.sourceWidth = std::max(width >> (level - 1), 1u);
+        levelFilter.sourceHeight = std::max(height >> (level - 1), 1u);
+        levelFilter.width = std::max(width >> level, 1u);
+        levelFilter.height = std::max(height >> level, 1u);
+        levelFilter.tapsX = buildTaps(levelFilter.sourceWidth, levelFilter.width, filter);
+        levelFilter.tapsY = buildTaps(levelFilter.sourceHeight, levelFilter.height, filter);
+        levelFilter.srgb = srgb;
+        size_t sourceLayerSize = size_t(levelFilter.sourceWidth) * levelFilter.sourceHeight * 4;
+        size_t layerSize = size_t(levelFilter.width) * levelFilter.height * 4;
+        size_t offset = sourceOffset + sourceLayerSize * layers;
+
+        uint32_t bandCount = (levelFilter.height + BAND_ROWS - 1) / BAND_ROWS;
+        ThreadPool::global().parallelFor(bandCount * layers, [&](uint32_t task) {
+            uint32_t layer = task / bandCount;
+            uint32_t band = task % bandCount;
+            const uint8_t *source = chain.data() + sourceOffset + sourceLayerSize * layer;
+            uint8_t *layerTexels = chain.data() + offset + layerSize * layer;
+            filterBand(tables, levelFilter, source, layerTexels, band * BAND_ROWS, std::min((band + 1) * BAND_ROWS, levelFilter.height));
+        });
+        sourceOffset = offset;
+    }
+    return chain;
+}
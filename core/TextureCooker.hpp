@@ -0,0 +1,42 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TEXTURECOOKER_HPP
+#define VULKAN_EXPERIMENTS_TEXTURECOOKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "TextureCompressor.hpp"
+
+class Texture;
+
+enum class MipFilter {
+    // average of the texels under the smaller texel
+    BOX,
+    // windowed sinc over three texels of the smaller level on each side, keeps more detail than BOX
+    KAISER,
+};
+
+// Builds what the backend uploads for textures ahead of time, the mip chain instead of blitting it on the GPU and
+// block compressed texels
+class TextureCooker {
+public:
+    // levels down to 1x1, the same count the backend blits
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+    // bytes of the first level levels of a chain, every level holds all layers
+    static size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t layers, uint32_t levels, TextureFormat format = TextureFormat::RGBA8);
+
+    // replaces the RGBA8 data of texture with its mip chain when it has mipmaps, compressed to texture.format. The
+    // cooked texels are owned by texture.cookedData
+    static void cook(Texture &texture);
+
+    // texels holds the layers of the base level one after another, the result holds every level after it the same way.
+    // The levels are filtered in linear space, color channels of sRGB textures are decoded first and alpha never is.
+    // Rows of a level are split between the threads of the global pool
+    static std::vector<uint8_t> buildMipChain(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t layers, bool srgb, MipFilter filter = MipFilter::KAISER);
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TEXTURECOOKER_HPP
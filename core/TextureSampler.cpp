@@ -0,0 +1,341 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "TextureSampler.hpp"
+#include "Texture.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SAMPLER_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SAMPLER_USE_SSE
+#endif
+
+namespace {
+
+const uint32_t TILE_SHIFT = 3;
+const uint32_t TILE_MASK = (1u << TILE_SHIFT) - 1;
+
+struct TexelGrid {
+    const uint8_t *texels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tilesX;
+    bool tiled;
+};
+
+// moves the three low bits of value to every second bit
+inline uint32_t spreadBits(uint32_t value) {
+    return (value & 1u) | ((value & 2u) << 1) | ((value & 4u) << 2);
+}
+
+inline uint32_t getTexelIndex(const TexelGrid &grid, uint32_t x, uint32_t y) {
+    if (grid.tiled) {
+        uint32_t tile = (y >> TILE_SHIFT) * grid.tilesX + (x >> TILE_SHIFT);
+        return (tile << (2 * TILE_SHIFT)) | spreadBits(x & TILE_MASK) | (spreadBits(y & TILE_MASK) << 1);
+    }
+    return y * grid.width + x;
+}
+
+inline uint32_t loadTexel(const TexelGrid &grid, uint32_t x, uint32_t y) {
+    uint32_t texel;
+    std::memcpy(&texel, grid.texels + size_t(getTexelIndex(grid, x, y)) * 4, sizeof(texel));
+    return texel;
+}
+
+inline float getChannel(uint32_t texel, uint32_t channel) {
+    return float((texel >> (channel * 8)) & 0xffu);
+}
+
+// the same steps as the SIMD paths, so every uv gets the same result whichever path it goes through
+glm::vec4 sampleTexel(const TexelGrid &grid, const glm::vec2 &uv) {
+    float maxX = float(grid.width - 1);
+    float maxY = float(grid.height - 1);
+    float x = std::min(std::max(0.0f, uv.x), 1.0f) * maxX;
+    float y = std::min(std::max(0.0f, uv.y), 1.0f) * maxY;
+    float x0 = float(int32_t(x));
+    float y0 = float(int32_t(y));
+    float x1 = std::min(x0 + 1.0f, maxX);
+    float y1 = std::min(y0 + 1.0f, maxY);
+    float weightX = x - x0;
+    float weightY = y - y0;
+    uint32_t texel00 = loadTexel(grid, uint32_t(x0), uint32_t(y0));
+    uint32_t texel10 = loadTexel(grid, uint32_t(x1), uint32_t(y0));
+    uint32_t texel01 = loadTexel(grid, uint32_t(x0), uint32_t(y1));
+    uint32_t texel11 = loadTexel(grid, uint32_t(x1), uint32_t(y1));
+    glm::vec4 result;
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        float c00 = getChannel(texel00, channel);
+        float c10 = getChannel(texel10, channel);
+        float c01 = getChannel(texel01, channel);
+        float c11 = getChannel(texel11, channel);
+        float top = c00 + (c10 - c00) * weightX;
+        float bottom = c01 + (c11 - c01) * weightX;
+        result[channel] = top + (bottom - top) * weightY;
+    }
+    return result;
+}
+
+#if defined(SAMPLER_USE_AVX2)
+
+const size_t BATCH_SIZE = 8;
+
+// the four texels around eight uvs in the order 00, 10, 01, 11 and the weights of the second texel on each axis
+struct Footprint {
+    __m256i texels[4];
+    __m256 weightX;
+    __m256 weightY;
+};
+
+inline __m256i getTexelIndices(const TexelGrid &grid, __m256i x, __m256i y) {
+    if (grid.tiled) {
+        __m256i tileMask = _mm256_set1_epi32(TILE_MASK);
+        __m256i tile = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(y, TILE_SHIFT), _mm256_set1_epi32(int32_t(grid.tilesX))),
+                                        _mm256_srli_epi32(x, TILE_SHIFT));
+        __m256i inTileX = _mm256_and_si256(x, tileMask);
+        __m256i inTileY = _mm256_and_si256(y, tileMask);
+        // the three bits of x go to bits 0, 2 and 4, the ones of y to bits 1, 3 and 5
+        __m256i morton = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(inTileX, _mm256_set1_epi32(1)),
+                                                         _mm256_slli_epi32(_mm256_and_si256(inTileX, _mm256_set1_epi32(2)), 1)),
+                                         _mm256_slli_epi32(_mm256_and_si256(inTileX, _mm256_set1_epi32(4)), 2));
+        morton = _mm256_or_si256(morton, _mm256_slli_epi32(_mm256_and_si256(inTileY, _mm256_set1_epi32(1)), 1));
+        morton = _mm256_or_si256(morton, _mm256_slli_epi32(_mm256_and_si256(inTileY, _mm256_set1_epi32(2)), 2));
+        morton = _mm256_or_si256(morton, _mm256_slli_epi32(_mm256_and_si256(inTileY, _mm256_set1_epi32(4)), 3));
+        return _mm256_or_si256(_mm256_slli_epi32(tile, 2 * TILE_SHIFT), morton);
+    }
+    return _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(int32_t(grid.width))), x);
+}
+
+inline void loadFootprint(const TexelGrid &grid, const glm::vec2 *uvs, Footprint &footprint) {
+    __m256 first = _mm256_loadu_ps(&uvs[0].x);
+    __m256 second = _mm256_loadu_ps(&uvs[4].x);
+    // the in-lane shuffle leaves the coordinates in pairs of uvs 0 1, 4 5, 2 3, 6 7, the permute puts them in order
+    __m256 u = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+    __m256 v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 maxX = _mm256_set1_ps(float(grid.width - 1));
+    __m256 maxY = _mm256_set1_ps(float(grid.height - 1));
+    __m256 x = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(u, zero), one), maxX);
+    __m256 y = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v, zero), one), maxY);
+    __m256 x0 = _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256 y0 = _mm256_round_ps(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256i texelX0 = _mm256_cvttps_epi32(x0);
+    __m256i texelY0 = _mm256_cvttps_epi32(y0);
+    __m256i texelX1 = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(x0, one), maxX));
+    __m256i texelY1 = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_add_ps(y0, one), maxY));
+    footprint.weightX = _mm256_sub_ps(x, x0);
+    footprint.weightY = _mm256_sub_ps(y, y0);
+    auto texels = reinterpret_cast<const int *>(grid.texels);
+    footprint.texels[0] = _mm256_i32gather_epi32(texels, getTexelIndices(grid, texelX0, texelY0), 4);
+    footprint.texels[1] = _mm256_i32gather_epi32(texels, getTexelIndices(grid, texelX1, texelY0), 4);
+    footprint.texels[2] = _mm256_i32gather_epi32(texels, getTexelIndices(grid, texelX0, texelY1), 4);
+    footprint.texels[3] = _mm256_i32gather_epi32(texels, getTexelIndices(grid, texelX1, texelY1), 4);
+}
+
+inline __m256 getChannels(__m256i texels, uint32_t channel) {
+    return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(texels, _mm_cvtsi32_si128(int(channel * 8))), _mm256_set1_epi32(0xff)));
+}
+
+inline __m256 filterChannel(const Footprint &footprint, uint32_t channel) {
+    __m256 c00 = getChannels(footprint.texels[0], channel);
+    __m256 c10 = getChannels(footprint.texels[1], channel);
+    __m256 c01 = getChannels(footprint.texels[2], channel);
+    __m256 c11 = getChannels(footprint.texels[3], channel);
+    __m256 top = _mm256_add_ps(c00, _mm256_mul_ps(_mm256_sub_ps(c10, c00), footprint.weightX));
+    __m256 bottom = _mm256_add_ps(c01, _mm256_mul_ps(_mm256_sub_ps(c11, c01), footprint.weightX));
+    return _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), footprint.weightY));
+}
+
+inline void storeFiltered(const Footprint &footprint, glm::vec4 *results) {
+    __m256 red = filterChannel(footprint, 0);
+    __m256 green = filterChannel(footprint, 1);
+    __m256 blue = filterChannel(footprint, 2);
+    __m256 alpha = filterChannel(footprint, 3);
+    // channels of four uvs per half transposed into four vec4s
+    for (int half = 0; half < 2; half++) {
+        __m128 r = half ? _mm256_extractf128_ps(red, 1) : _mm256_castps256_ps128(red);
+        __m128 g = half ? _mm256_extractf128_ps(green, 1) : _mm256_castps256_ps128(green);
+        __m128 b = half ? _mm256_extractf128_ps(blue, 1) : _mm256_castps256_ps128(blue);
+        __m128 a = half ? _mm256_extractf128_ps(alpha, 1) : _mm256_castps256_ps128(alpha);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        _mm_storeu_ps(&results[half * 4].x, r);
+        _mm_storeu_ps(&results[half * 4 + 1].x, g);
+        _mm_storeu_ps(&results[half * 4 + 2].x, b);
+        _mm_storeu_ps(&results[half * 4 + 3].x, a);
+    }
+}
+
+inline void storeFiltered(const Footprint &footprint, uint32_t channel, float *results) {
+    _mm256_storeu_ps(results, filterChannel(footprint, channel));
+}
+
+#elif defined(SAMPLER_USE_SSE)
+
+const size_t BATCH_SIZE = 4;
+
+// SSE2 has no gathers, the indices are computed four at a time and the texels loaded one by one
+struct Footprint {
+    __m128i texels[4];
+    __m128 weightX;
+    __m128 weightY;
+};
+
+// SSE2 only multiplies unsigned 32-bit pairs into 64 bits, the even and odd lanes are done apart
+inline __m128i multiplyLow(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+inline __m128i getTexelIndices(const TexelGrid &grid, __m128i x, __m128i y) {
+    if (grid.tiled) {
+        __m128i tileMask = _mm_set1_epi32(TILE_MASK);
+        __m128i tile = _mm_add_epi32(multiplyLow(_mm_srli_epi32(y, TILE_SHIFT), _mm_set1_epi32(int32_t(grid.tilesX))), _mm_srli_epi32(x, TILE_SHIFT));
+        __m128i inTileX = _mm_and_si128(x, tileMask);
+        __m128i inTileY = _mm_and_si128(y, tileMask);
+        // the three bits of x go to bits 0, 2 and 4, the ones of y to bits 1, 3 and 5
+        __m128i morton = _mm_or_si128(_mm_or_si128(_mm_and_si128(inTileX, _mm_set1_epi32(1)),
+                                                   _mm_slli_epi32(_mm_and_si128(inTileX, _mm_set1_epi32(2)), 1)),
+                                      _mm_slli_epi32(_mm_and_si128(inTileX, _mm_set1_epi32(4)), 2));
+        morton = _mm_or_si128(morton, _mm_slli_epi32(_mm_and_si128(inTileY, _mm_set1_epi32(1)), 1));
+        morton = _mm_or_si128(morton, _mm_slli_epi32(_mm_and_si128(inTileY, _mm_set1_epi32(2)), 2));
+        morton = _mm_or_si128(morton, _mm_slli_epi32(_mm_and_si128(inTileY, _mm_set1_epi32(4)), 3));
+        return _mm_or_si128(_mm_slli_epi32(tile, 2 * TILE_SHIFT), morton);
+    }
+    return _mm_add_epi32(multiplyLow(y, _mm_set1_epi32(int32_t(grid.width))), x);
+}
+
+inline __m128i gatherTexels(const TexelGrid &grid, __m128i indices) {
+    alignas(16) uint32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), indices);
+    uint32_t texels[4];
+    for (int lane = 0; lane < 4; lane++) {
+        std::memcpy(&texels[lane], grid.texels + size_t(lanes[lane]) * 4, sizeof(uint32_t));
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(texels));
+}
+
+inline void loadFootprint(const TexelGrid &grid, const glm::vec2 *uvs, Footprint &footprint) {
+    __m128 first = _mm_loadu_ps(&uvs[0].x);
+    __m128 second = _mm_loadu_ps(&uvs[2].x);
+    __m128 u = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 v = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 maxX = _mm_set1_ps(float(grid.width - 1));
+    __m128 maxY = _mm_set1_ps(float(grid.height - 1));
+    __m128 x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(u, zero), one), maxX);
+    __m128 y = _mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), maxY);
+    __m128i texelX0 = _mm_cvttps_epi32(x);
+    __m128i texelY0 = _mm_cvttps_epi32(y);
+    __m128 x0 = _mm_cvtepi32_ps(texelX0);
+    __m128 y0 = _mm_cvtepi32_ps(texelY0);
+    __m128i texelX1 = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(x0, one), maxX));
+    __m128i texelY1 = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(y0, one), maxY));
+    footprint.weightX = _mm_sub_ps(x, x0);
+    footprint.weightY = _mm_sub_ps(y, y0);
+    footprint.texels[0] = gatherTexels(grid, getTexelIndices(grid, texelX0, texelY0));
+    footprint.texels[1] = gatherTexels(grid, getTexelIndices(grid, texelX1, texelY0));
+    footprint.texels[2] = gatherTexels(grid, getTexelIndices(grid, texelX0, texelY1));
+    footprint.texels[3] = gatherTexels(grid, getTexelIndices(grid, texelX1, texelY1));
+}
+
+inline __m128 getChannels(__m128i texels, uint32_t channel) {
+    return _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(texels, _mm_cvtsi32_si128(int(channel * 8))), _mm_set1_epi32(0xff)));
+}
+
+inline __m128 filterChannel(const Footprint &footprint, uint32_t channel) {
+    __m128 c00 = getChannels(footprint.texels[0], channel);
+    __m128 c10 = getChannels(footprint.texels[1], channel);
+    __m128 c01 = getChannels(footprint.texels[2], channel);
+    __m128 c11 = getChannels(footprint.texels[3], channel);
+    __m128 top = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), footprint.weightX));
+    __m128 bottom = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), footprint.weightX));
+    return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), footprint.weightY));
+}
+
+inline void storeFiltered(const Footprint &footprint, glm::vec4 *results) {
+    __m128 r = filterChannel(footprint, 0);
+    __m128 g = filterChannel(footprint, 1);
+    __m128 b = filterChannel(footprint, 2);
+    __m128 a = filterChannel(footprint, 3);
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    _mm_storeu_ps(&results[0].x, r);
+    _mm_storeu_ps(&results[1].x, g);
+    _mm_storeu_ps(&results[2].x, b);
+    _mm_storeu_ps(&results[3].x, a);
+}
+
+inline void storeFiltered(const Footprint &footprint, uint32_t channel, float *results) {
+    _mm_storeu_ps(results, filterChannel(footprint, channel));
+}
+
+#endif
+
+}
+
+TextureSampler::TextureSampler(const Texture &texture, TexelLayout layout) : width(uint32_t(texture.width)), height(uint32_t(texture.height)), layout(layout) {
+    if (!texture.data || texture.width <= 0 || texture.height <= 0) {
+        throw std::runtime_error("Texture has no texels to sample");
+    }
+    if (TextureCompressor::isBlockCompressed(texture.format)) {
+        throw std::runtime_error("Block compressed textures can't be sampled on the CPU");
+    }
+    if (layout == TexelLayout::LINEAR) {
+        linearTexels = texture.data;
+        return;
+    }
+    // the tiles at the right and bottom edges are padded, their texels past the edge are never read
+    tilesX = (width + TILE_MASK) >> TILE_SHIFT;
+    uint32_t tilesY = (height + TILE_MASK) >> TILE_SHIFT;
+    tiledTexels.resize((size_t(tilesX) * tilesY) << (2 * TILE_SHIFT));
+    TexelGrid linear = {texture.data, width, height, 0, false};
+    TexelGrid tiled = {nullptr, width, height, tilesX, true};
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            tiledTexels[getTexelIndex(tiled, x, y)] = loadTexel(linear, x, y);
+        }
+    }
+}
+
+void TextureSampler::sample(const glm::vec2 *uvs, size_t count, glm::vec4 *results) const {
+    TexelGrid grid = {getTexels(), width, height, tilesX, layout == TexelLayout::TILED};
+    size_t i = 0;
+#if defined(SAMPLER_USE_AVX2) || defined(SAMPLER_USE_SSE)
+    Footprint footprint;
+    for (; i + BATCH_SIZE <= count; i += BATCH_SIZE) {
+        loadFootprint(grid, uvs + i, footprint);
+        storeFiltered(footprint, results + i);
+    }
+#endif
+    for (; i < count; i++) {
+        results[i] = sampleTexel(grid, uvs[i]);
+    }
+}
+
+void TextureSampler::sample(const glm::vec2 *uvs, size_t count, uint32_t channel, float *results) const {
+    TexelGrid grid = {getTexels(), width, height, tilesX, layout == TexelLayout::TILED};
+    size_t i = 0;
+#if defined(SAMPLER_USE_AVX2) || defined(SAMPLER_USE_SSE)
+    Footprint footprint;
+    for (; i + BATCH_SIZE <= count; i += BATCH_SIZE) {
+        loadFootprint(grid, uvs + i, footprint);
+        storeFiltered(footprint, channel, results + i);
+    }
+#endif
+    for (; i < count; i++) {
+        results[i] = sampleTexel(grid, uvs[i])[channel];
+    }
+}
+
+glm::vec4 TextureSampler::getTexel(uint32_t x, uint32_t y) const {
+    TexelGrid grid = {getTexels(), width, height, tilesX, layout == TexelLayout::TILED};
+    uint32_t texel = loadTexel(grid, x, y);
+    return {getChannel(texel, 0), getChannel(texel, 1), getChannel(texel, 2), getChannel(texel, 3)};
+}
@@ -0,0 +1,56 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_TEXTURESAMPLER_HPP
+#define VULKAN_EXPERIMENTS_TEXTURESAMPLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+class Texture;
+
+enum class TexelLayout {
+    // rows one after another, as the texture data is
+    LINEAR,
+    // 8x8 tiles in rows with the texels of a tile in Morton order, so the four texels of a bilinear footprint are
+    // mostly in one cache line
+    TILED,
+};
+
+// Bilinear sampling of RGBA8 textures on the CPU for whole arrays of uvs. Built with AVX2 the texels are gathered
+// eight uvs at a time, with SSE2 four uvs share the filter math, other targets run a scalar loop
+class TextureSampler {
+public:
+    TextureSampler() = default;
+    // LINEAR reads the texture data in place, so the texture has to outlive the sampler. TILED keeps its own copy
+    explicit TextureSampler(const Texture &texture, TexelLayout layout = TexelLayout::LINEAR);
+
+    // uvs are clamped to [0, 1] and map to the texel centers at the edges, the channels are in [0, 255] like
+    // Texture::getPixelColor
+    void sample(const glm::vec2 *uvs, size_t count, glm::vec4 *results) const;
+    // only one channel, for heights and other single channel data
+    void sample(const glm::vec2 *uvs, size_t count, uint32_t channel, float *results) const;
+
+    uint32_t getWidth() const { return width; }
+    uint32_t getHeight() const { return height; }
+    TexelLayout getLayout() const { return layout; }
+    // the texel at x, y without filtering, in either layout
+    glm::vec4 getTexel(uint32_t x, uint32_t y) const;
+
+private:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // tiles in a row of the TILED layout
+    uint32_t tilesX = 0;
+    TexelLayout layout = TexelLayout::LINEAR;
+    const uint8_t *linearTexels = nullptr;
+    std::vector<uint32_t> tiledTexels;
+
+    const uint8_t *getTexels() const { return layout == TexelLayout::TILED ? reinterpret_cast<const uint8_t *>(tiledTexels.data()) : linearTexels; }
+};
+
+
+#endif //VULKAN_EXPERIMENTS_TEXTURESAMPLER_HPP
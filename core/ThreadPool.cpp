@@ -0,0 +1,95 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <atomic>
+#include <exception>
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+    struct State {
+        std::atomic<uint32_t> next{0};
+        std::atomic<uint32_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        // first exception thrown by body, the indices after it are skipped
+        std::atomic<bool> failed{false};
+        std::exception_ptr exception;
+    };
+    auto state = std::make_shared<State>();
+    // helpers that start after every index is taken return without touching body,
+    // so the caller only has to wait for indices that are already running
+    auto run = [state, count, &body]() {
+        for (uint32_t i = state->next++; i < count; i = state->next++) {
+            // a throwing index still counts as done, so the caller never waits for it and never leaves while body runs
+            if (!state->failed) {
+                try {
+                    body(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->exception) {
+                        state->exception = std::current_exception();
+                    }
+                    state->failed = true;
+                }
+            }
+            if (++state->done == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+    uint32_t helperCount = std::min(count - 1, getThreadCount());
+    for (uint32_t i = 0; i < helperCount; i++) {
+        submit(run);
+    }
+    run();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,59 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_THREADPOOL_HPP
+#define VULKAN_EXPERIMENTS_THREADPOOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()));
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<F>> {
+        auto packagedTask = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+        auto future = packagedTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([packagedTask]() { (*packagedTask)(); });
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    // run body(i) for every i in [0, count) on the workers and the calling thread, returns when all are done. The first
+    // exception body throws is rethrown here, the indices not started by then are skipped
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)> &body);
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+    // pool shared by the loaders
+    static ThreadPool &global();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+};
+
+
+#endif //VULKAN_EXPERIMENTS_THREADPOOL_HPP
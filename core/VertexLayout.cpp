@@ -0,0 +1,187 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "glm/gtc/packing.hpp"
+#include "VertexLayout.hpp"
+#include "Mesh.hpp"
+
+namespace {
+
+uint16_t packUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+int16_t packSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+int8_t packSnorm8(float value) {
+    return static_cast<int8_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+glm::vec3 getBoundsCenter(const Bounds &bounds) {
+    return (bounds.min + bounds.max) * 0.5f;
+}
+
+// flat dimensions keep a unit extent so the quantization never divides by zero
+glm::vec3 getBoundsExtent(const Bounds &bounds) {
+    glm::vec3 extent = bounds.max - bounds.min;
+    for (int i = 0; i < 3; i++) {
+        if (extent[i] <= 0.0f) extent[i] = 1.0f;
+    }
+    return extent;
+}
+
+// half floats around the bounds center, w is 1
+void encodeHalfPosition(const glm::vec3 &position, const Bounds &bounds, uint16_t *output) {
+    glm::vec3 centered = position - getBoundsCenter(bounds);
+    for (int i = 0; i < 3; i++) {
+        output[i] = glm::packHalf1x16(centered[i]);
+    }
+    output[3] = glm::packHalf1x16(1.0f);
+}
+
+// unorm16 inside the bounds
+void encodeUnormPosition(const glm::vec3 &position, const Bounds &bounds, uint16_t *output) {
+    glm::vec3 normalized = (position - bounds.min) / getBoundsExtent(bounds);
+    for (int i = 0; i < 3; i++) {
+        output[i] = packUnorm16(normalized[i]);
+    }
+}
+
+template<typename T>
+void encodeVertexArray(const std::vector<Vertex> &vertices, const Bounds &bounds, void *destination) {
+    auto output = static_cast<T *>(destination);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        output[i] = T::encode(vertices[i], bounds);
+    }
+}
+
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3 &normal) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    glm::vec3 n = normal / length;
+    glm::vec2 encoded(n.x, n.y);
+    if (n.z < 0.0f) {
+        // fold the lower hemisphere over the diagonals of the octahedron
+        encoded.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return encoded;
+}
+
+HalfVertex HalfVertex::encode(const Vertex &vertex, const Bounds &bounds) {
+    HalfVertex result{};
+    encodeHalfPosition(vertex.position, bounds, result.position);
+    glm::vec2 normal = encodeOctahedral(vertex.normal);
+    result.normal[0] = packSnorm16(normal.x);
+    result.normal[1] = packSnorm16(normal.y);
+    result.uv[0] = glm::packHalf1x16(vertex.uv.x);
+    result.uv[1] = glm::packHalf1x16(vertex.uv.y);
+    return result;
+}
+
+CompactVertex CompactVertex::encode(const Vertex &vertex, const Bounds &bounds) {
+    CompactVertex result{};
+    encodeUnormPosition(vertex.position, bounds, result.position);
+    glm::vec2 normal = encodeOctahedral(vertex.normal);
+    result.normal[0] = packSnorm8(normal.x);
+    result.normal[1] = packSnorm8(normal.y);
+    result.uv[0] = packUnorm16(vertex.uv.x);
+    result.uv[1] = packUnorm16(vertex.uv.y);
+    return result;
+}
+
+uint32_t getVertexStride(VertexLayout layout) {
+    switch (layout) {
+        case VertexLayout::HALF:
+            return sizeof(HalfVertex);
+        case VertexLayout::COMPACT:
+            return sizeof(CompactVertex);
+        default:
+            return sizeof(Vertex);
+    }
+}
+
+uint32_t getPositionStride(VertexLayout layout) {
+    return layout == VertexLayout::STANDARD ? sizeof(glm::vec3) : sizeof(QuantizedPosition);
+}
+
+VertexLayout chooseCompactVertexLayout(const std::vector<Vertex> &vertices) {
+    for (const auto &vertex : vertices) {
+        if (vertex.uv.x < 0.0f || vertex.uv.x > 1.0f || vertex.uv.y < 0.0f || vertex.uv.y > 1.0f) {
+            return VertexLayout::HALF;
+        }
+    }
+    return VertexLayout::COMPACT;
+}
+
+void encodeVertices(VertexLayout layout, const std::vector<Vertex> &vertices, const Bounds &bounds, void *destination) {
+    switch (layout) {
+        case VertexLayout::HALF:
+            encodeVertexArray<HalfVertex>(vertices, bounds, destination);
+            break;
+        case VertexLayout::COMPACT:
+            encodeVertexArray<CompactVertex>(vertices, bounds, destination);
+            break;
+        default:
+            std::copy(vertices.begin(), vertices.end(), static_cast<Vertex *>(destination));
+            break;
+    }
+}
+
+void encodePositions(VertexLayout layout, const std::vector<Vertex> &vertices, const Bounds &bounds, void *destination) {
+    if (layout == VertexLayout::STANDARD) {
+        auto output = static_cast<glm::vec3 *>(destination);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            output[i] = vertices[i].position;
+        }
+        return;
+    }
+    auto output = static_cast<QuantizedPosition *>(destination);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        output[i] = {};
+        if (layout == VertexLayout::HALF) {
+            encodeHalfPosition(vertices[i].position, bounds, output[i].position);
+        }
+        else {
+            encodeUnormPosition(vertices[i].position, bounds, output[i].position);
+        }
+    }
+}
+
+void extractPositions(VertexLayout layout, const void *vertices, size_t count, void *destination) {
+    // every layout starts with its position, the compact one has no w and leaves it zero
+    size_t positionSize = layout == VertexLayout::COMPACT ? sizeof(CompactVertex::position) : getPositionStride(layout);
+    size_t vertexStride = getVertexStride(layout);
+    size_t positionStride = getPositionStride(layout);
+    auto input = static_cast<const uint8_t *>(vertices);
+    auto output = static_cast<uint8_t *>(destination);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(output + i * positionStride, input + i * vertexStride, positionSize);
+        memset(output + i * positionStride + positionSize, 0, positionStride - positionSize);
+    }
+}
+
+glm::mat4 getDequantizationTransform(VertexLayout layout, const Bounds &bounds) {
+    glm::mat4 transform(1.0f);
+    if (layout == VertexLayout::HALF) {
+        transform[3] = glm::vec4(getBoundsCenter(bounds), 1.0f);
+    }
+    else if (layout == VertexLayout::COMPACT) {
+        glm::vec3 extent = getBoundsExtent(bounds);
+        transform[0][0] = extent.x;
+        transform[1][1] = extent.y;
+        transform[2][2] = extent.z;
+        transform[3] = glm::vec4(bounds.min, 1.0f);
+    }
+    return transform;
+}
@@ -0,0 +1,76 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_VERTEXLAYOUT_HPP
+#define VULKAN_EXPERIMENTS_VERTEXLAYOUT_HPP
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+struct Vertex;
+struct Bounds;
+
+enum class VertexLayout : uint32_t {
+    // float position, normal, color and uv, 44 bytes
+    STANDARD = 0,
+    // half float position around the bounds center, octahedral snorm16 normal, half float uv, 16 bytes
+    HALF,
+    // unorm16 position inside the bounds, octahedral snorm8 normal in the fourth position component, unorm16 uv, 12 bytes
+    COMPACT,
+};
+
+// attributes a pipeline reads per instance from a second vertex binding, after those of its VertexLayout
+enum class InstanceLayout : uint32_t {
+    NONE = 0,
+    // TerrainNode, two vec4 at locations 4 and 5
+    TERRAIN_NODE,
+};
+
+struct HalfVertex {
+    static constexpr VertexLayout layout = VertexLayout::HALF;
+
+    uint16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+
+    static HalfVertex encode(const Vertex &vertex, const Bounds &bounds);
+};
+static_assert(sizeof(HalfVertex) == 16);
+
+struct CompactVertex {
+    static constexpr VertexLayout layout = VertexLayout::COMPACT;
+
+    uint16_t position[3];
+    int8_t normal[2];
+    uint16_t uv[2];
+
+    static CompactVertex encode(const Vertex &vertex, const Bounds &bounds);
+};
+static_assert(sizeof(CompactVertex) == 12);
+
+// Element of the position-only stream of the quantized layouts, same encoding as their interleaved position.
+// STANDARD meshes keep plain glm::vec3 positions
+struct QuantizedPosition {
+    uint16_t position[4];
+};
+static_assert(sizeof(QuantizedPosition) == 8);
+
+uint32_t getVertexStride(VertexLayout layout);
+uint32_t getPositionStride(VertexLayout layout);
+// COMPACT needs every uv inside [0, 1] to quantize it, HALF takes the rest
+VertexLayout chooseCompactVertexLayout(const std::vector<Vertex> &vertices);
+// write vertices in the given layout to destination, which holds getVertexStride(layout) * vertices.size() bytes
+void encodeVertices(VertexLayout layout, const std::vector<Vertex> &vertices, const Bounds &bounds, void *destination);
+// write only the positions, destination holds getPositionStride(layout) * vertices.size() bytes
+void encodePositions(VertexLayout layout, const std::vector<Vertex> &vertices, const Bounds &bounds, void *destination);
+// copy the positions out of count vertices already in the given layout, writes the bytes encodePositions writes
+void extractPositions(VertexLayout layout, const void *vertices, size_t count, void *destination);
+// maps quantized positions back to object space, to be applied before the model matrix
+glm::mat4 getDequantizationTransform(VertexLayout layout, const Bounds &bounds);
+
+glm::vec2 encodeOctahedral(const glm::vec3 &normal);
+
+
+#endif //VULKAN_EXPERIMENTS_VERTEXLAYOUT_HPP
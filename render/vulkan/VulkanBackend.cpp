@@ -4,13 +4,54 @@
 
 #include "VulkanBackend.hpp"
 #include "VulkanPipelineBuilder.hpp"
+#include "core/MeshCache.hpp"
+#include "core/TextureCooker.hpp"
+#include "core/ThreadPool.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 
+namespace {
+
+// first level of texture that is at most tailSize texels on a side
+uint32_t getTailLevel(const Texture &texture, uint32_t tailSize) {
+    auto size = uint32_t(std::max(texture.width, texture.height));
+    uint32_t level = 0;
+    while (level + 1 < texture.mipLevels && (size >> level) > tailSize) {
+        level++;
+    }
+    return level;
+}
+
+// bytes of the levels of texture from firstLevel on
+VkDeviceSize getLevelsSize(const Texture &texture, uint32_t firstLevel) {
+    return TextureCooker::getMipChainSize(texture.width, texture.height, texture.layers, texture.mipLevels, texture.format) -
+           TextureCooker::getMipChainSize(texture.width, texture.height, texture.layers, firstLevel, texture.format);
+}
+
+VkFormat getTextureFormat(const Texture &texture) {
+    switch (texture.format) {
+        case TextureFormat::BC1:
+            return texture.srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case TextureFormat::BC3:
+            return texture.srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case TextureFormat::BC5:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureFormat::BC7:
+            return texture.srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        default:
+            return texture.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+}
+
 VulkanBackend::VulkanBackend(const std::shared_ptr<GLFWwindow>& window, std::string_view appName, uint32_t width, uint32_t height) {
     windowExtent = {width, height};
     VkApplicationInfo appInfo{};
@@ -24,9 +65,19 @@ VulkanBackend::VulkanBackend(const std::shared_ptr<GLFWwindow>& window, std::str
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
-    createInfo.enabledExtensionCount = 2;
-    const char* extensions[] = {VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WIN32_SURFACE_EXTENSION_NAME};
-    createInfo.ppEnabledExtensionNames = extensions;
+    std::vector<const char*> extensions = {VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WIN32_SURFACE_EXTENSION_NAME};
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+    for (const auto &extension : availableExtensions) {
+        if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            physicalDeviceProperties2Supported = true;
+        }
+    }
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create Vulkan instance");
@@ -44,6 +95,9 @@ VulkanBackend::VulkanBackend(const std::shared_ptr<GLFWwindow>& window, std::str
     allocatorInfo.physicalDevice = physicalDevice;
     allocatorInfo.device = device;
     allocatorInfo.instance = instance;
+    if (memoryBudgetSupported) {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
     vmaCreateAllocator(&allocatorInfo, &allocator);
 
     shaderLoader = std::unique_ptr<ShaderLoader>(new VulkanShaderLoader(device));
@@ -62,6 +116,55 @@ void VulkanBackend::init(uint32_t width, uint32_t height) {
 
 VulkanBackend::~VulkanBackend() {
     vkDeviceWaitIdle(device);
+    // workers still loading write into their uploads
+    for (auto &upload : meshUploads) {
+        if (upload.loaded.valid()) {
+            upload.loaded.wait();
+        }
+        if (upload.staging.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, upload.staging.buffer, upload.staging.allocation);
+        }
+    }
+    for (auto &upload : textureUploads) {
+        if (upload.loaded.valid()) {
+            upload.loaded.wait();
+        }
+        if (upload.staging.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, upload.staging.buffer, upload.staging.allocation);
+        }
+        // uploads still here own their images, finished ones were moved into loadedTextures
+        if (upload.resident.image.image != VK_NULL_HANDLE) {
+            vmaDestroyImage(allocator, upload.resident.image.image, upload.resident.image.allocation);
+            vkDestroyImageView(device, upload.resident.imageView, nullptr);
+        }
+    }
+    for (auto &mesh : meshes) {
+        destroyMesh(mesh.second);
+    }
+    for (auto &mesh : releasedMeshes) {
+        destroyMesh(mesh.second);
+    }
+    for (auto &copy : geometryPoolCopies) {
+        vmaDestroyBuffer(allocator, copy.source.buffer, copy.source.allocation);
+    }
+    for (auto &retired : retiredPoolBuffers) {
+        vmaDestroyBuffer(allocator, retired.second.buffer, retired.second.allocation);
+    }
+    for (auto &pool : vertexPools) {
+        destroyGeometryPool(pool);
+    }
+    for (auto &pool : indexPools) {
+        destroyGeometryPool(pool);
+    }
+    for (auto &frame : frames) {
+        if (frame.instanceBuffer.buffer != VK_NULL_HANDLE) {
+            vmaUnmapMemory(allocator, frame.instanceBuffer.allocation);
+            vmaDestroyBuffer(allocator, frame.instanceBuffer.buffer, frame.instanceBuffer.allocation);
+        }
+        if (frame.textureUploadBuffer.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, frame.textureUploadBuffer.buffer, frame.textureUploadBuffer.allocation);
+        }
+    }
     deletionQueue.flush();
     vmaDestroyAllocator(allocator);
     vkDestroySurfaceKHR(instance, surface, nullptr);
@@ -97,15 +200,37 @@ void VulkanBackend::createLogicalDevice() {
     float queuePriority = 1.0f;
     queueCreateInfo.pQueuePriorities = &queuePriority;
 
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
     VkPhysicalDeviceFeatures deviceFeatures{};
+    // one indirect call for all meshlets of a mesh, otherwise they are issued one by one
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    multiDrawIndirectSupported = supportedFeatures.multiDrawIndirect == VK_TRUE;
+    // patch pipelines for terrain, without it there is no terrain
+    deviceFeatures.tessellationShader = supportedFeatures.tessellationShader;
+    tessellationSupported = supportedFeatures.tessellationShader == VK_TRUE;
+    // cooked textures are compressed only when the device samples BCn
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    textureCompressionBCSupported = supportedFeatures.textureCompressionBC == VK_TRUE;
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
     deviceCreateInfo.queueCreateInfoCount = 1;
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
-    deviceCreateInfo.enabledExtensionCount = 1;
-    const char* deviceExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
+    std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    // texture streaming sizes its budget by what the driver reports as left on the heap
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+    for (const auto &extension : availableExtensions) {
+        if (physicalDeviceProperties2Supported && strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudgetSupported = true;
+        }
+    }
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
     if (vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create logical device");
@@ -197,6 +322,7 @@ void VulkanBackend::createQueue() {
     for (uint32_t i = 0; i < queueFamilies.size(); i++) {
         if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
             graphicsQueueFamilyIndex = i;
+            timestampsSupported = queueFamilies[i].timestampValidBits > 0 && gpuProperties.limits.timestampPeriod > 0.0f;
             break;
         }
     }
@@ -375,7 +501,22 @@ void VulkanBackend::createSemaphoresAndFences() {
             throw std::runtime_error("Failed to create fence");
         }
 
+        frame.timestampPool = VK_NULL_HANDLE;
+        frame.timestampsWritten = false;
+        if (timestampsSupported) {
+            VkQueryPoolCreateInfo queryPoolInfo = {};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = 2;
+            if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create timestamp query pool");
+            }
+        }
+
         deletionQueue.push_function([=, this]() {
+            if (frame.timestampPool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(device, frame.timestampPool, nullptr);
+            }
             vkDestroyFence(device, frame.renderFence, nullptr);
             vkDestroySemaphore(device, frame.presentSemaphore, nullptr);
             vkDestroySemaphore(device, frame.renderSemaphore, nullptr);
@@ -402,72 +543,531 @@ void VulkanBackend::recreateSwapchain(uint32_t width, uint32_t height) {
         createGraphicsPipeline(pipeline.first, pipeline.second.shader);
     }
     loadMeshes();
+    if (!meshletCullShader.stagesInfo.empty()) {
+        createMeshletCullPipeline(meshletCullShader);
+    }
 }
 
 void VulkanBackend::loadMeshes() {
+    // mesh buffers do not depend on the swapchain, they survive its recreation
     for (auto &mesh : meshes) {
-        uploadMesh(mesh.second);
+        if (mesh.second.state == MeshState::QUEUED) {
+            uploadMesh(mesh.second);
+        }
     }
+    meshesLoaded = true;
 }
 
 void VulkanBackend::uploadMesh(VulkanMesh& mesh) {
-    /*mesh.vertexBuffer.uploadBuffer(allocator, mesh.vertices.data(), sizeof(mesh.vertices[0]) * mesh.vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-    deletionQueue.push_function([=, this]() {
-        vmaDestroyBuffer(allocator, mesh.vertexBuffer.buffer, mesh.vertexBuffer.allocation);
-    });*/
-    const size_t bufferSize = mesh.vertices.size() * sizeof(Vertex);
-    VkBufferCreateInfo stagingBufferInfo = {};
-    stagingBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    stagingBufferInfo.pNext = nullptr;
-    stagingBufferInfo.size = bufferSize;
-    stagingBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    VmaAllocationCreateInfo vmaallocInfo = {};
-    vmaallocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-    VulkanBuffer stagingBuffer;
-    VK_CHECK(vmaCreateBuffer(allocator, &stagingBufferInfo, &vmaallocInfo, &stagingBuffer.buffer, &stagingBuffer.allocation, nullptr));
-
-    void* data;
-    vmaMapMemory(allocator, stagingBuffer.allocation, &data);
-    memcpy(data, mesh.vertices.data(), bufferSize);
+    auto layout = MeshStagingLayout::create(mesh);
+    auto copies = allocateMeshGeometry(mesh, layout);
+    mesh.state = MeshState::READY;
+    if (copies.empty()) {
+        return;
+    }
+    auto stagingBuffer = createBuffer(layout.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    void *mapped;
+    vmaMapMemory(allocator, stagingBuffer.allocation, &mapped);
+    layout.write(mesh, mapped);
     vmaUnmapMemory(allocator, stagingBuffer.allocation);
+    immediateSubmit([&](VkCommandBuffer commandBuffer) {
+        // the range of the mesh may lie in what a grown pool still has to copy over
+        recordGeometryPoolCopies(commandBuffer);
+        size_t nextCopy = 0;
+        VkDeviceSize copiedBytes = 0;
+        VkDeviceSize budget = VK_WHOLE_SIZE;
+        recordMeshCopies(commandBuffer, mesh, stagingBuffer, copies, nextCopy, copiedBytes, budget);
+    });
+    vmaDestroyBuffer(allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+}
 
-    VkBufferCreateInfo vertexBufferInfo = {};
-    vertexBufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    vertexBufferInfo.pNext = nullptr;
+std::vector<MeshBufferCopy> VulkanBackend::allocateMeshGeometry(VulkanMesh &mesh, const MeshStagingLayout &layout) {
+    std::vector<MeshBufferCopy> copies;
+    auto &vertexPool = getVertexPool(mesh);
+    vertexPool.stride = mesh.getVertexStride();
+    vertexPool.positionStride = mesh.getPositionStride();
+    mesh.vertexOffset = allocateGeometry(vertexPool, mesh.getVertexCount(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh.positionStream);
+    if (mesh.vertexOffset == RangeAllocator::INVALID_OFFSET) {
+        return copies;
+    }
+    copies.push_back({MeshBufferTarget::VERTICES, layout.vertexOffset, VkDeviceSize(mesh.vertexOffset) * vertexPool.stride, layout.vertexSize});
+    if (layout.positionSize > 0) {
+        copies.push_back({MeshBufferTarget::POSITIONS, layout.positionOffset, VkDeviceSize(mesh.vertexOffset) * vertexPool.positionStride, layout.positionSize});
+    }
 
-    vertexBufferInfo.size = bufferSize;
-    vertexBufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    vmaallocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-    VK_CHECK(vmaCreateBuffer(allocator, &vertexBufferInfo, &vmaallocInfo, &mesh.vertexBuffer.buffer, &mesh.vertexBuffer.allocation, nullptr));
+    mesh.meshletCount = mesh.getMeshletCount();
+    if (mesh.meshletCount > 0) {
+        // a slot for every instance placed so far, later ones beyond that are culled on the CPU
+        mesh.meshletDrawSlots = std::max(mesh.referenceCount, 1u);
+        mesh.meshletBuffer = createBuffer(layout.meshletSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+        mesh.meshletDrawBuffer = createBuffer(size_t(mesh.meshletCount) * mesh.meshletDrawSlots * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+        copies.push_back({MeshBufferTarget::MESHLETS, layout.meshletOffset, 0, layout.meshletSize});
+    }
 
-    immediateSubmit([&](VkCommandBuffer commandBuffer) {
+    // whole mesh draws use the full resolution lod, the coarser ones follow it in the same index range
+    mesh.indexCount = mesh.getLodCount() > 0 ? mesh.getLods()[0].indexCount : mesh.getIndexCount();
+    if (mesh.indexCount == 0) {
+        return copies;
+    }
+    mesh.indexType = layout.indexStride == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    auto &indexPool = getIndexPool(mesh);
+    indexPool.stride = layout.indexStride;
+    // indices stay relative to the mesh, the draws add vertexOffset
+    mesh.firstIndex = allocateGeometry(indexPool, mesh.getIndexCount(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, false);
+    copies.push_back({MeshBufferTarget::INDICES, layout.indexOffset, VkDeviceSize(mesh.firstIndex) * indexPool.stride, layout.indexSize});
+    return copies;
+}
+
+void VulkanBackend::recordMeshCopies(VkCommandBuffer cmd, const VulkanMesh &mesh, const VulkanBuffer &staging, const std::vector<MeshBufferCopy> &copies,
+                                     size_t &nextCopy, VkDeviceSize &copiedBytes, VkDeviceSize &budget) {
+    while (nextCopy < copies.size() && budget > 0) {
+        const auto &copy = copies[nextCopy];
+        VkBuffer target = VK_NULL_HANDLE;
+        switch (copy.target) {
+            case MeshBufferTarget::VERTICES:
+                target = getVertexPool(mesh).buffer.buffer;
+                break;
+            case MeshBufferTarget::POSITIONS:
+                target = getVertexPool(mesh).positionBuffer.buffer;
+                break;
+            case MeshBufferTarget::INDICES:
+                target = getIndexPool(mesh).buffer.buffer;
+                break;
+            case MeshBufferTarget::MESHLETS:
+                target = mesh.meshletBuffer.buffer;
+                break;
+        }
         VkBufferCopy copyRegion = {};
-        copyRegion.size = bufferSize;
-        copyRegion.dstOffset = 0;
-        copyRegion.srcOffset = 0;
-        vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, mesh.vertexBuffer.buffer, 1, &copyRegion);
-    });
+        copyRegion.srcOffset = copy.srcOffset + copiedBytes;
+        copyRegion.dstOffset = copy.dstOffset + copiedBytes;
+        copyRegion.size = std::min(copy.size - copiedBytes, budget);
+        vkCmdCopyBuffer(cmd, staging.buffer, target, 1, &copyRegion);
+        budget -= copyRegion.size;
+        copiedBytes += copyRegion.size;
+        if (copiedBytes == copy.size) {
+            nextCopy++;
+            copiedBytes = 0;
+        }
+    }
+}
 
-    deletionQueue.push_function([=, this]() {
-        vmaDestroyBuffer(allocator, mesh.vertexBuffer.buffer, mesh.vertexBuffer.allocation);
+std::string VulkanBackend::loadMeshAsync(const std::string &name, const std::string &path, const MeshImportOptions &options) {
+    if (meshes.contains(name)) {
+        return name;
+    }
+    auto alias = meshAliases.find(name);
+    if (alias != meshAliases.end()) {
+        if (meshes.contains(alias->second)) {
+            return alias->second;
+        }
+        meshAliases.erase(alias);
+    }
+    meshes[name].state = MeshState::LOADING;
+    auto &upload = meshUploads.emplace_back();
+    upload.mesh = name;
+    upload.start = std::chrono::steady_clock::now();
+    // the worker only touches the upload, which stays in place in the list until its future is consumed
+    upload.loaded = ThreadPool::global().submit([this, &upload, path, options]() {
+        if (!upload.source.loadFromObj(path.c_str(), options)) {
+            return false;
+        }
+        try {
+            stageMeshUpload(upload);
+        }
+        catch (const std::exception &e) {
+            if (!upload.source.isCooked()) {
+                throw;
+            }
+            // a cache that does not decode would fail every later launch too, it is replaced by importing the obj again
+            std::cout << "Mesh cache of " << path << " is corrupt, importing it again: " << e.what() << std::endl;
+            upload.source = Mesh();
+            std::error_code error;
+            std::filesystem::remove(MeshCache::getCachePath(path.c_str()), error);
+            if (!upload.source.loadFromObj(path.c_str(), options)) {
+                return false;
+            }
+            stageMeshUpload(upload);
+        }
+        return true;
     });
-    vmaDestroyBuffer(allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+    return name;
 }
 
-void VulkanBackend::addMesh(const std::string &name, const Mesh &mesh) {
-    VulkanMesh vulkanMesh = {};
-    vulkanMesh.vertices = mesh.vertices;
-    vulkanMesh.vertexBuffer = {};
-    meshes[name] = vulkanMesh;
-    //uploadMesh(*vulkanMesh);
+void VulkanBackend::stageMeshUpload(MeshUpload &upload) {
+    upload.layout = MeshStagingLayout::create(upload.source);
+    if (upload.layout.size == 0) {
+        return;
+    }
+    upload.staging = createBuffer(upload.layout.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    void *mapped;
+    vmaMapMemory(allocator, upload.staging.allocation, &mapped);
+    try {
+        upload.layout.write(upload.source, mapped);
+    }
+    catch (...) {
+        vmaUnmapMemory(allocator, upload.staging.allocation);
+        vmaDestroyBuffer(allocator, upload.staging.buffer, upload.staging.allocation);
+        upload.staging = {};
+        throw;
+    }
+    upload.contentHash = upload.layout.hashStreams(upload.source, mapped);
+    vmaUnmapMemory(allocator, upload.staging.allocation);
+}
+
+void VulkanBackend::updateMeshUploads() {
+    for (auto upload = meshUploads.begin(); upload != meshUploads.end();) {
+        if (upload->loaded.valid()) {
+            if (upload->loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++upload;
+                continue;
+            }
+            bool loaded = false;
+            std::string error = "cannot read the file";
+            try {
+                loaded = upload->loaded.get();
+            }
+            catch (const std::exception &e) {
+                error = e.what();
+            }
+            if (!upload->cancelled && !loaded) {
+                meshes[upload->mesh].state = MeshState::FAILED;
+                std::cout << "Failed to load mesh " << upload->mesh << ": " << error << std::endl;
+                upload->cancelled = true;
+            }
+            if (!upload->cancelled && upload->staging.buffer != VK_NULL_HANDLE) {
+                // a mesh with the same streams is already on the GPU, its buffers are drawn instead of a second copy
+                void *mapped;
+                vmaMapMemory(allocator, upload->staging.allocation, &mapped);
+                std::string same = findMeshWithStreams(upload->source, upload->layout, mapped, upload->contentHash);
+                vmaUnmapMemory(allocator, upload->staging.allocation);
+                if (!same.empty()) {
+                    std::cout << "Streamed mesh " << upload->mesh << " has the content of " << same << ", sharing its buffers" << std::endl;
+                    aliasMesh(upload->mesh, same);
+                    upload->cancelled = true;
+                }
+            }
+            if (!upload->cancelled) {
+                // allocating may grow a geometry pool, which is done here before the frame is recorded
+                auto &mesh = meshes[upload->mesh];
+                static_cast<Mesh &>(mesh) = std::move(upload->source);
+                mesh.contentHash = upload->contentHash;
+                mesh.state = MeshState::UPLOADING;
+                upload->copies = allocateMeshGeometry(mesh, upload->layout);
+                upload->lastFrame = frameNumber;
+            }
+        }
+        bool recorded = upload->cancelled || upload->nextCopy == upload->copies.size();
+        if (!recorded || upload->lastFrame + FRAME_OVERLAP > frameNumber) {
+            ++upload;
+            continue;
+        }
+        if (!upload->cancelled) {
+            auto &mesh = meshes[upload->mesh];
+            mesh.state = MeshState::READY;
+            if (meshletCullSetLayout != VK_NULL_HANDLE) {
+                createMeshletCullSet(mesh);
+            }
+            std::cout << (mesh.isCooked() ? "Streamed cooked mesh " : "Streamed mesh ") << upload->mesh << ": " << mesh.getVertexCount() << " vertices, " << mesh.getIndexCount() << " indices, " << mesh.getVertexStride() << " bytes per vertex in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - upload->start).count() << " ms" << std::endl;
+        }
+        if (upload->staging.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, upload->staging.buffer, upload->staging.allocation);
+        }
+        upload = meshUploads.erase(upload);
+    }
+}
+
+void VulkanBackend::recordMeshUploads() {
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    VkDeviceSize budget = MESH_UPLOAD_BUDGET;
+    bool recorded = !geometryPoolCopies.empty();
+    recordGeometryPoolCopies(cmd);
+    for (auto &upload : meshUploads) {
+        if (upload.cancelled || upload.loaded.valid() || upload.nextCopy == upload.copies.size()) {
+            continue;
+        }
+        recordMeshCopies(cmd, meshes[upload.mesh], upload.staging, upload.copies, upload.nextCopy, upload.copiedBytes, budget);
+        upload.lastFrame = frameNumber;
+        recorded = true;
+        if (budget == 0) {
+            break;
+        }
+    }
+    if (!recorded) {
+        return;
+    }
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 }
 
-VkImageCreateInfo VulkanBackend::createImageInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent) {
+void VulkanBackend::destroyMesh(VulkanMesh &mesh) {
+    if (mesh.vertexOffset != RangeAllocator::INVALID_OFFSET) {
+        getVertexPool(mesh).allocator.free(mesh.vertexOffset);
+        mesh.vertexOffset = RangeAllocator::INVALID_OFFSET;
+    }
+    if (mesh.firstIndex != RangeAllocator::INVALID_OFFSET) {
+        getIndexPool(mesh).allocator.free(mesh.firstIndex);
+        mesh.firstIndex = RangeAllocator::INVALID_OFFSET;
+    }
+    VulkanBuffer *buffers[] = {&mesh.meshletBuffer, &mesh.meshletDrawBuffer};
+    for (auto buffer : buffers) {
+        if (buffer->buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, buffer->buffer, buffer->allocation);
+            *buffer = {};
+        }
+    }
+}
+
+uint32_t VulkanBackend::allocateGeometry(VulkanGeometryPool &pool, uint32_t count, VkBufferUsageFlags usage, bool positions) {
+    if (count == 0) {
+        return RangeAllocator::INVALID_OFFSET;
+    }
+    uint32_t offset = pool.allocator.allocate(count);
+    if (offset == RangeAllocator::INVALID_OFFSET) {
+        // doubling keeps the number of reallocations logarithmic in the geometry uploaded
+        uint32_t capacity = pool.allocator.getCapacity();
+        growGeometryPool(pool, std::max(GEOMETRY_POOL_MIN_CAPACITY, std::max(capacity * 2, capacity + count)), usage, positions);
+        offset = pool.allocator.allocate(count);
+    }
+    else if (positions && pool.positionBuffer.buffer == VK_NULL_HANDLE) {
+        growGeometryPool(pool, pool.allocator.getCapacity(), usage, positions);
+    }
+    return offset;
+}
+
+void VulkanBackend::growGeometryPool(VulkanGeometryPool &pool, uint32_t capacity, VkBufferUsageFlags usage, bool positions) {
+    // the old buffers may still be read by frames in flight, they are copied from in the next recorded frame and
+    // destroyed once that frame has finished instead of waiting for the device here
+    uint32_t oldCapacity = pool.allocator.getCapacity();
+    auto grow = [&](VulkanBuffer &buffer, uint32_t stride) {
+        if (buffer.buffer != VK_NULL_HANDLE && capacity == oldCapacity) {
+            return;
+        }
+        auto grown = createBuffer(size_t(capacity) * stride, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+        if (buffer.buffer != VK_NULL_HANDLE) {
+            auto pending = std::find_if(geometryPoolCopies.begin(), geometryPoolCopies.end(), [&](const GeometryPoolCopy &copy) {
+                return copy.target == buffer.buffer;
+            });
+            if (pending != geometryPoolCopies.end()) {
+                // grown twice before a frame was recorded, nothing has used the buffer in between
+                pending->target = grown.buffer;
+                vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+            }
+            else {
+                geometryPoolCopies.push_back({buffer, grown.buffer, VkDeviceSize(oldCapacity) * stride});
+            }
+        }
+        buffer = grown;
+    };
+    grow(pool.buffer, pool.stride);
+    if (positions || pool.positionBuffer.buffer != VK_NULL_HANDLE) {
+        grow(pool.positionBuffer, pool.positionStride);
+    }
+    pool.allocator.grow(capacity);
+    std::cout << "Geometry pool grown to " << capacity << " elements of " << pool.stride << " bytes" << std::endl;
+    boundVertexPool = nullptr;
+    boundIndexPool = nullptr;
+}
+
+void VulkanBackend::destroyGeometryPool(VulkanGeometryPool &pool) {
+    VulkanBuffer *buffers[] = {&pool.buffer, &pool.positionBuffer};
+    for (auto buffer : buffers) {
+        if (buffer->buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(allocator, buffer->buffer, buffer->allocation);
+            *buffer = {};
+        }
+    }
+}
+
+void VulkanBackend::recordGeometryPoolCopies(VkCommandBuffer cmd) {
+    if (geometryPoolCopies.empty()) {
+        return;
+    }
+    for (const auto &copy : geometryPoolCopies) {
+        VkBufferCopy copyRegion = {};
+        copyRegion.size = copy.size;
+        vkCmdCopyBuffer(cmd, copy.source.buffer, copy.target, 1, &copyRegion);
+        retiredPoolBuffers.emplace_back(frameNumber, copy.source);
+    }
+    geometryPoolCopies.clear();
+    // the mesh copies that follow may write ranges the pool copies also write
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+std::string VulkanBackend::findMeshWithStreams(const Mesh &mesh, const MeshStagingLayout &layout, const void *data, uint64_t contentHash) {
+    std::vector<uint8_t> existingData;
+    for (const auto &existing : meshes) {
+        if (existing.second.contentHash != contentHash || existing.second.getLodCount() != mesh.getLodCount()) {
+            continue;
+        }
+        // the hash only narrows it down, the streams are written out again and compared
+        auto existingLayout = MeshStagingLayout::create(existing.second);
+        existingData.resize(existingLayout.size);
+        existingLayout.write(existing.second, existingData.data());
+        if (existing.second.vertexLayout == mesh.vertexLayout && layout.equalStreams(data, existingLayout, existingData.data()) &&
+            memcmp(existing.second.getLods(), mesh.getLods(), mesh.getLodCount() * sizeof(MeshLod)) == 0) {
+            return existing.first;
+        }
+    }
+    return {};
+}
+
+std::string VulkanBackend::addMesh(const std::string &name, const Mesh &mesh) {
+    auto layout = MeshStagingLayout::create(mesh);
+    std::vector<uint8_t> data(layout.size);
+    layout.write(mesh, data.data());
+    uint64_t contentHash = layout.hashStreams(mesh, data.data());
+    std::string same = findMeshWithStreams(mesh, layout, data.data(), contentHash);
+    if (!same.empty()) {
+        return same;
+    }
+    if (meshes.contains(name)) {
+        throw std::runtime_error("Mesh " + name + " already exists with other content");
+    }
+    meshAliases.erase(name);
+    VulkanMesh &vulkanMesh = meshes[name];
+    static_cast<Mesh &>(vulkanMesh) = mesh;
+    vulkanMesh.contentHash = contentHash;
+    if (meshesLoaded) {
+        uploadMesh(vulkanMesh);
+        if (meshletCullSetLayout != VK_NULL_HANDLE) {
+            createMeshletCullSet(vulkanMesh);
+        }
+    }
+    return name;
+}
+
+void VulkanBackend::aliasMesh(const std::string &name, const std::string &target) {
+    auto mesh = meshes.find(name);
+    auto &targetMesh = meshes.at(target);
+    for (auto &instance : instances) {
+        if (instance.second.mesh == name) {
+            instance.second.mesh = target;
+        }
+    }
+    targetMesh.referenceCount += mesh->second.referenceCount;
+    // nothing was allocated for it yet, it only held the state while loading
+    meshes.erase(mesh);
+    for (auto &alias : meshAliases) {
+        if (alias.second == name) {
+            alias.second = target;
+        }
+    }
+    meshAliases[name] = target;
+}
+
+uint32_t VulkanBackend::addInstance(const MeshInstance &instance) {
+    auto alias = meshAliases.find(instance.mesh);
+    const std::string &name = alias != meshAliases.end() ? alias->second : instance.mesh;
+    auto mesh = meshes.find(name);
+    if (mesh == meshes.end()) {
+        throw std::runtime_error("Unknown mesh " + instance.mesh);
+    }
+    mesh->second.referenceCount++;
+    uint32_t id = nextInstanceId++;
+    instances[id] = instance;
+    instances[id].mesh = name;
+    return id;
+}
+
+void VulkanBackend::removeInstance(uint32_t id) {
+    auto instance = instances.find(id);
+    if (instance == instances.end()) {
+        return;
+    }
+    auto mesh = meshes.find(instance->second.mesh);
+    instances.erase(instance);
+    if (--mesh->second.referenceCount > 0) {
+        return;
+    }
+    if (mesh->second.state == MeshState::LOADING || mesh->second.state == MeshState::UPLOADING) {
+        for (auto &upload : meshUploads) {
+            if (upload.mesh == mesh->first) {
+                upload.cancelled = true;
+            }
+        }
+    }
+    releasedMeshes.emplace_back(frameNumber, std::move(mesh->second));
+    meshes.erase(mesh);
+}
+
+bool VulkanBackend::updateTexture(const std::string &name, const std::vector<TextureRegion> &regions) {
+    auto texture = loadedTextures.find(name);
+    if (texture == loadedTextures.end()) {
+        throw std::runtime_error("Unknown texture " + name);
+    }
+    auto &frame = getCurrentFrame();
+    VkDeviceSize size = 0;
+    for (const auto &region : regions) {
+        size += VkDeviceSize(region.width) * region.height * 4;
+    }
+    if (size == 0) {
+        return true;
+    }
+    if (frame.textureUploadUsed + size > TEXTURE_UPLOAD_BUDGET) {
+        return false;
+    }
+    if (frame.textureUploadBuffer.buffer == VK_NULL_HANDLE) {
+        frame.textureUploadBuffer = createBuffer(TEXTURE_UPLOAD_BUDGET, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    }
+
+    // regions are packed tightly into the staging buffer, row by row
+    std::vector<VkBufferImageCopy> copies;
+    void *mapped;
+    vmaMapMemory(allocator, frame.textureUploadBuffer.allocation, &mapped);
+    for (const auto &region : regions) {
+        VkBufferImageCopy copy = {};
+        copy.bufferOffset = frame.textureUploadUsed;
+        copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.imageSubresource.mipLevel = 0;
+        copy.imageSubresource.baseArrayLayer = region.layer;
+        copy.imageSubresource.layerCount = 1;
+        copy.imageOffset = {int32_t(region.x), int32_t(region.y), 0};
+        copy.imageExtent = {region.width, region.height, 1};
+        copies.push_back(copy);
+        size_t rowSize = size_t(region.width) * 4;
+        for (uint32_t row = 0; row < region.height; row++) {
+            memcpy(static_cast<uint8_t *>(mapped) + frame.textureUploadUsed, region.data + size_t(row) * region.rowLength * 4, rowSize);
+            frame.textureUploadUsed += rowSize;
+        }
+    }
+    vmaUnmapMemory(allocator, frame.textureUploadBuffer.allocation);
+
+    auto cmd = frame.mainCommandBuffer;
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture->second.image.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, texture->second.texture.layers};
+    // the texels outside of the regions are kept, so the layout changes from what the shaders read
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdCopyBufferToImage(cmd, frame.textureUploadBuffer.buffer, barrier.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(copies.size()), copies.data());
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    return true;
+}
+
+VkImageCreateInfo VulkanBackend::createImageInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent, uint32_t mipLevels) {
     VkImageCreateInfo imageInfo = {};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
     imageInfo.extent = extent;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -479,7 +1079,7 @@ VkImageCreateInfo VulkanBackend::createImageInfo(VkFormat format, VkImageUsageFl
     return imageInfo;
 }
 
-VkImageViewCreateInfo VulkanBackend::createImageViewInfo(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags) {
+VkImageViewCreateInfo VulkanBackend::createImageViewInfo(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
@@ -487,7 +1087,7 @@ VkImageViewCreateInfo VulkanBackend::createImageViewInfo(VkFormat format, VkImag
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -529,21 +1129,28 @@ void VulkanBackend::createGraphicsPipeline(const std::string &name, const Shader
         throw std::runtime_error("Failed to create pipeline layout " + name);
     }
 
-    VertexInputDescription vertexDescription = VulkanVertex::getVertexDescription();
-
     VulkanPipelineBuilder pipelineBuilder;
 
     for (auto &stage : vulkanShader.stages) {
         pipelineBuilder.shaderStages.push_back(VulkanPipelineBuilder::createShaderStageInfo(stage.stage, stage.module));
     }
 
-    pipelineBuilder.vertexInputInfo = VulkanPipelineBuilder::createVertexInputInfo(std::shared_ptr<std::vector<VkVertexInputBindingDescription>>(&vertexDescription.bindings, [](std::vector<VkVertexInputBindingDescription>*) {}),
-                                                                                   std::shared_ptr<std::vector<VkVertexInputAttributeDescription>>(&vertexDescription.attributes, [](std::vector<VkVertexInputAttributeDescription>*) {}));
-    pipelineBuilder.inputAssembly = VulkanPipelineBuilder::createInputAssemblyInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    pipelineBuilder.vertexInputInfo = VulkanVertex::getVertexInputInfo(pipelineShader.vertexLayout, pipelineShader.depthOnly, pipelineShader.instanceLayout);
+    if (pipelineShader.patchControlPoints > 0) {
+        pipelineBuilder.inputAssembly = VulkanPipelineBuilder::createInputAssemblyInfo(VK_PRIMITIVE_TOPOLOGY_PATCH_LIST);
+        pipelineBuilder.tessellation = VulkanPipelineBuilder::createTessellationInfo(pipelineShader.patchControlPoints);
+    }
+    else {
+        pipelineBuilder.inputAssembly = VulkanPipelineBuilder::createInputAssemblyInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    }
     pipelineBuilder.rasterizer = VulkanPipelineBuilder::createRasterizerInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE);
     pipelineBuilder.multisampling = VulkanPipelineBuilder::createMultisamplingInfo(VK_SAMPLE_COUNT_1_BIT);
     pipelineBuilder.colorBlendAttachment = VulkanPipelineBuilder::createColorBlendAttachmentState();
-    pipelineBuilder.depthStencil = VulkanPipelineBuilder::createDepthStencilInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS);
+    if (pipelineShader.depthOnly) {
+        pipelineBuilder.colorBlendAttachment.colorWriteMask = 0;
+    }
+    // LESS_OR_EQUAL so that the color pass still passes on the depth a prepass has already written
+    pipelineBuilder.depthStencil = VulkanPipelineBuilder::createDepthStencilInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
 
     pipelineBuilder.viewport = {};
     pipelineBuilder.viewport.x = 0.0f;
@@ -561,18 +1168,17 @@ void VulkanBackend::createGraphicsPipeline(const std::string &name, const Shader
     auto pipeline = pipelineBuilder.buildPipeline(device, renderPass);
 
     deletionQueue.push_function([=, this]() {
-        for (auto &texture : loadedTextures) {
-            vmaDestroyImage(allocator, texture.second.image.image, texture.second.image.allocation);
-            vkDestroyImageView(device, texture.second.imageView, nullptr);
-            std::cout << "Destroyed texture " << texture.first << std::endl;
-        }
         for (auto &stage : vulkanShader.stages) {
             vkDestroyShaderModule(device, stage.module, nullptr);
         }
         vkDestroyPipeline(device, pipeline, nullptr);
         vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     });
-    materials[name] = VulkanMaterial{vulkanShader, pipeline, pipelineLayout};
+    materials[name] = VulkanMaterial{vulkanShader, pipeline, pipelineLayout, VK_NULL_HANDLE, VulkanVertex::getVertexFormatHash(pipelineShader.vertexLayout, pipelineShader.depthOnly, pipelineShader.instanceLayout)};
+    // depth only pipelines have no fragment stage and sample no textures
+    if (pipelineShader.depthOnly) {
+        return;
+    }
     /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 
     VkDescriptorSetAllocateInfo allocInfo = {};
@@ -581,24 +1187,19 @@ void VulkanBackend::createGraphicsPipeline(const std::string &name, const Shader
     allocInfo.descriptorPool = descriptorPool;
     allocInfo.descriptorSetCount = 1;
     allocInfo.pSetLayouts = &singleTextureSetLayout;
-    vkAllocateDescriptorSets(device, &allocInfo, &materials[name].textureSet);
+    if (vkAllocateDescriptorSets(device, &allocInfo, &materials[name].textureSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate the texture set of material " + name);
+    }
 
     std::vector<VkWriteDescriptorSet> descriptorWrites;
     for (auto &texture : loadedTextures) {
-        VkSamplerCreateInfo samplerInfo;
-        samplerInfo = createSamplerCreateInfo(VK_FILTER_NEAREST);
-        VkSampler blockySampler;
-        vkCreateSampler(device, &samplerInfo, nullptr, &blockySampler);
         //write to the descriptor set so that it points to our texture
         VkDescriptorImageInfo *imageBufferInfo = new VkDescriptorImageInfo();
-        imageBufferInfo->sampler = blockySampler;
+        imageBufferInfo->sampler = getTextureSampler(texture.second);
         imageBufferInfo->imageView = texture.second.imageView;
         imageBufferInfo->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
         descriptorWrites.push_back(createWriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, materials[name].textureSet, imageBufferInfo, texture.second.binding));
-        deletionQueue.push_function([=, this]() {
-            vkDestroySampler(device, blockySampler, nullptr);
-        });
     }
     vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     // delete imageBufferInfo pointers
@@ -607,6 +1208,91 @@ void VulkanBackend::createGraphicsPipeline(const std::string &name, const Shader
     }
 }
 
+void VulkanBackend::createMeshletCullPipeline(const Shader &cullShader) {
+    meshletCullShader = cullShader;
+    auto vulkanShader = VulkanShader(device, cullShader);
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = 2;
+    setLayoutInfo.pBindings = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &meshletCullSetLayout));
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(MeshletCullConstants);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = VulkanPipelineBuilder::createPipelineLayoutInfo();
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &meshletCullSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &meshletCullPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout " + cullShader.name);
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = VulkanPipelineBuilder::createShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT, vulkanShader.stages[0].module);
+    pipelineInfo.layout = meshletCullPipelineLayout;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &meshletCullPipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline " + cullShader.name);
+    }
+
+    deletionQueue.push_function([=, this]() {
+        for (auto &stage : vulkanShader.stages) {
+            vkDestroyShaderModule(device, stage.module, nullptr);
+        }
+        vkDestroyPipeline(device, meshletCullPipeline, nullptr);
+        vkDestroyPipelineLayout(device, meshletCullPipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, meshletCullSetLayout, nullptr);
+    });
+
+    for (auto &mesh : meshes) {
+        if (mesh.second.state == MeshState::READY) {
+            createMeshletCullSet(mesh.second);
+        }
+    }
+}
+
+void VulkanBackend::createMeshletCullSet(VulkanMesh &mesh) {
+    if (mesh.meshletCount == 0) {
+        return;
+    }
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &meshletCullSetLayout;
+    // without a set the mesh is culled on the CPU
+    if (vkAllocateDescriptorSets(device, &allocInfo, &mesh.meshletCullSet) != VK_SUCCESS) {
+        mesh.meshletCullSet = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkDescriptorBufferInfo bufferInfos[2] = {
+            {mesh.meshletBuffer.buffer, 0, VK_WHOLE_SIZE},
+            {mesh.meshletDrawBuffer.buffer, 0, VK_WHOLE_SIZE}
+    };
+    VkWriteDescriptorSet writes[2] = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = mesh.meshletCullSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+}
+
 void VulkanBackend::bindPipeline(const std::string &name) {
     currentPipeline = materials[name];
     vkCmdBindPipeline(getCurrentFrame().mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline.pipeline);
@@ -616,6 +1302,43 @@ void VulkanBackend::bindPipeline(const std::string &name) {
 void VulkanBackend::beginFrame() {
     vkWaitForFences(device, 1, &getCurrentFrame().renderFence, VK_TRUE, UINT64_MAX);
     vkResetFences(device, 1, &getCurrentFrame().renderFence);
+    if (getCurrentFrame().timestampsWritten) {
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(device, getCurrentFrame().timestampPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            gpuFrameTime = float(double(timestamps[1] - timestamps[0]) * gpuProperties.limits.timestampPeriod * 1e-6);
+        }
+        getCurrentFrame().timestampsWritten = false;
+    }
+    // the instances and texels written by the last use of this frame have been consumed
+    getCurrentFrame().instanceBufferUsed = 0;
+    getCurrentFrame().textureUploadUsed = 0;
+    reserveInstanceBuffer(getCurrentFrame());
+
+    // every frame that was recorded while a released mesh was alive has finished once its fence is waited for
+    std::erase_if(releasedMeshes, [this](auto &released) {
+        if (released.first + FRAME_OVERLAP > frameNumber) {
+            return false;
+        }
+        destroyMesh(released.second);
+        return true;
+    });
+    std::erase_if(retiredPoolBuffers, [this](auto &retired) {
+        if (retired.first + FRAME_OVERLAP > frameNumber) {
+            return false;
+        }
+        vmaDestroyBuffer(allocator, retired.second.buffer, retired.second.allocation);
+        return true;
+    });
+    updateMeshUploads();
+    updateTextureUploads();
+    // the heap budgets are refreshed as the frames go
+    vmaSetCurrentFrameIndex(allocator, static_cast<uint32_t>(frameNumber));
+    updateTextureStreaming();
+    for (auto &mesh : meshes) {
+        mesh.second.meshletDrawSlotsUsed = 0;
+    }
+    boundVertexPool = nullptr;
+    boundIndexPool = nullptr;
 
     auto result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, getCurrentFrame().presentSemaphore, VK_NULL_HANDLE, &currentImageIndex);
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -630,6 +1353,16 @@ void VulkanBackend::beginFrame() {
     beginInfo.pInheritanceInfo = nullptr;
 
     vkBeginCommandBuffer(getCurrentFrame().mainCommandBuffer, &beginInfo);
+    // the uploads count towards the frame time
+    if (getCurrentFrame().timestampPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(getCurrentFrame().mainCommandBuffer, getCurrentFrame().timestampPool, 0, 2);
+        vkCmdWriteTimestamp(getCurrentFrame().mainCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, getCurrentFrame().timestampPool, 0);
+    }
+    recordMeshUploads();
+    recordTextureUploads();
+}
+
+void VulkanBackend::beginRenderPass() {
     VkClearValue clearValue;
     clearValue.color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
 
@@ -653,21 +1386,157 @@ void VulkanBackend::beginFrame() {
 void VulkanBackend::drawMeshes() {
     //vkCmdBindPipeline(mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentPipeline.pipeline);
     //vkCmdPushConstants(mainCommandBuffer, currentPipeline.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &meshMatrix);
-    VkDeviceSize offset = 0;
     for (auto& mesh : meshes) {
-        vkCmdBindVertexBuffers(getCurrentFrame().mainCommandBuffer, 0, 1, &mesh.second.vertexBuffer.buffer, &offset);
-        vkCmdDraw(getCurrentFrame().mainCommandBuffer, mesh.second.vertices.size(), 1, 0, 0);
+        if (mesh.second.indexCount > 0) {
+            drawMeshIndexed(mesh.second);
+            continue;
+        }
+        drawMesh(mesh.second);
+    }
+}
+
+void VulkanBackend::bindGeometry(const VulkanMesh &mesh, bool depthOnly) {
+    // a pipeline built for another vertex format would read the mesh's vertices with the wrong strides and offsets
+    if (VulkanVertex::getVertexFormatHash(mesh.vertexLayout, depthOnly, currentPipeline.shader.instanceLayout) != currentPipeline.vertexFormatHash) {
+        throw std::runtime_error("Mesh vertex format does not match the bound pipeline " + currentPipeline.shader.name);
+    }
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    const auto &vertexPool = getVertexPool(mesh);
+    if (boundVertexPool != &vertexPool || boundPositions != depthOnly) {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(cmd, 0, 1, depthOnly ? &vertexPool.positionBuffer.buffer : &vertexPool.buffer.buffer, &offset);
+        boundVertexPool = &vertexPool;
+        boundPositions = depthOnly;
+    }
+    if (mesh.indexCount == 0) {
+        return;
+    }
+    const auto &indexPool = getIndexPool(mesh);
+    if (boundIndexPool != &indexPool) {
+        vkCmdBindIndexBuffer(cmd, indexPool.buffer.buffer, 0, mesh.indexType);
+        boundIndexPool = &indexPool;
     }
 }
 
 void VulkanBackend::drawMesh(const VulkanMesh &mesh) {
-    VkDeviceSize offset = 0;
-    vkCmdBindVertexBuffers(getCurrentFrame().mainCommandBuffer, 0, 1, &mesh.vertexBuffer.buffer, &offset);
-    vkCmdDraw(getCurrentFrame().mainCommandBuffer, mesh.vertices.size(), 1, 0, 0);
+    bindGeometry(mesh, false);
+    vkCmdDraw(getCurrentFrame().mainCommandBuffer, mesh.getVertexCount(), 1, mesh.vertexOffset, 0);
+}
+
+void VulkanBackend::drawMeshIndexed(const VulkanMesh &mesh) {
+    bindGeometry(mesh, false);
+    vkCmdDrawIndexed(getCurrentFrame().mainCommandBuffer, mesh.indexCount, 1, mesh.firstIndex, int32_t(mesh.vertexOffset), 0);
+}
+
+void VulkanBackend::drawMeshInstanced(const VulkanMesh &mesh, const IndexRange &range, const void *instances, uint32_t instanceCount,
+                                      uint32_t instanceStride) {
+    auto &frame = getCurrentFrame();
+    VkDeviceSize size = VkDeviceSize(instanceCount) * instanceStride;
+    if (instanceCount == 0 || range.indexCount == 0) {
+        return;
+    }
+    if (frame.instanceBufferUsed + size > frame.instanceBufferSize) {
+        // told once per growth, the buffer is replaced when the frame comes round again
+        if (frame.instanceBufferNeeded <= frame.instanceBufferSize) {
+            std::cout << "Instance buffer is full, " << instanceCount << " instances are not drawn this frame" << std::endl;
+        }
+        frame.instanceBufferNeeded = std::max(frame.instanceBufferNeeded, frame.instanceBufferUsed + size);
+        return;
+    }
+    memcpy(static_cast<uint8_t *>(frame.instanceBufferMapped) + frame.instanceBufferUsed, instances, size);
+
+    bindGeometry(mesh, false);
+    VkDeviceSize offset = frame.instanceBufferUsed;
+    vkCmdBindVertexBuffers(frame.mainCommandBuffer, 1, 1, &frame.instanceBuffer.buffer, &offset);
+    vkCmdDrawIndexed(frame.mainCommandBuffer, range.indexCount, instanceCount, mesh.firstIndex + range.firstIndex, int32_t(mesh.vertexOffset), 0);
+    frame.instanceBufferUsed += size;
+}
+
+void VulkanBackend::reserveInstanceBuffer(FrameData &frame) {
+    if (frame.instanceBuffer.buffer != VK_NULL_HANDLE && frame.instanceBufferNeeded <= frame.instanceBufferSize) {
+        return;
+    }
+    VkDeviceSize size = std::max(frame.instanceBufferSize, INSTANCE_BUFFER_SIZE);
+    while (size < frame.instanceBufferNeeded) {
+        size *= 2;
+    }
+    // the fence of the frame has signalled, nothing reads the old buffer any more
+    if (frame.instanceBuffer.buffer != VK_NULL_HANDLE) {
+        vmaUnmapMemory(allocator, frame.instanceBuffer.allocation);
+        vmaDestroyBuffer(allocator, frame.instanceBuffer.buffer, frame.instanceBuffer.allocation);
+    }
+    frame.instanceBuffer = createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    vmaMapMemory(allocator, frame.instanceBuffer.allocation, &frame.instanceBufferMapped);
+    frame.instanceBufferSize = size;
+    frame.instanceBufferNeeded = 0;
+}
+
+void VulkanBackend::drawMeshDepth(const VulkanMesh &mesh) {
+    bindGeometry(mesh, true);
+    if (mesh.indexCount > 0) {
+        vkCmdDrawIndexed(getCurrentFrame().mainCommandBuffer, mesh.indexCount, 1, mesh.firstIndex, int32_t(mesh.vertexOffset), 0);
+    }
+    else {
+        vkCmdDraw(getCurrentFrame().mainCommandBuffer, mesh.getVertexCount(), 1, mesh.vertexOffset, 0);
+    }
+}
+
+uint32_t VulkanBackend::cullMeshlets(VulkanMesh &mesh, const MeshletCullConstants &constants) {
+    if (mesh.meshletCullSet == VK_NULL_HANDLE || mesh.meshletDrawSlotsUsed == mesh.meshletDrawSlots) {
+        return NO_DRAW_SLOT;
+    }
+    uint32_t slot = mesh.meshletDrawSlotsUsed++;
+    MeshletCullConstants slotConstants = constants;
+    slotConstants.drawOffset = slot * mesh.meshletCount;
+    slotConstants.firstIndex = mesh.firstIndex;
+    slotConstants.vertexOffset = int32_t(mesh.vertexOffset);
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, meshletCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, meshletCullPipelineLayout, 0, 1, &mesh.meshletCullSet, 0, nullptr);
+    vkCmdPushConstants(cmd, meshletCullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MeshletCullConstants), &slotConstants);
+    vkCmdDispatch(cmd, (mesh.meshletCount + 63) / 64, 1, 1);
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = mesh.meshletDrawBuffer.buffer;
+    barrier.offset = slotConstants.drawOffset * sizeof(VkDrawIndexedIndirectCommand);
+    barrier.size = mesh.meshletCount * sizeof(VkDrawIndexedIndirectCommand);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    return slot;
+}
+
+void VulkanBackend::drawMeshletsIndirect(const VulkanMesh &mesh, uint32_t slot, bool depthOnly) {
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    bindGeometry(mesh, depthOnly);
+    VkDeviceSize drawOffset = VkDeviceSize(slot) * mesh.meshletCount * sizeof(VkDrawIndexedIndirectCommand);
+    // culled meshlets are left in the buffer with an index count of 0
+    if (multiDrawIndirectSupported) {
+        vkCmdDrawIndexedIndirect(cmd, mesh.meshletDrawBuffer.buffer, drawOffset, mesh.meshletCount, sizeof(VkDrawIndexedIndirectCommand));
+        return;
+    }
+    for (uint32_t i = 0; i < mesh.meshletCount; i++) {
+        vkCmdDrawIndexedIndirect(cmd, mesh.meshletDrawBuffer.buffer, drawOffset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+void VulkanBackend::drawMeshRanges(const VulkanMesh &mesh, const std::vector<IndexRange> &ranges, bool depthOnly) {
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    bindGeometry(mesh, depthOnly);
+    for (const auto &range : ranges) {
+        vkCmdDrawIndexed(cmd, range.indexCount, 1, mesh.firstIndex + range.firstIndex, int32_t(mesh.vertexOffset), 0);
+    }
 }
 
 void VulkanBackend::endFrame() {
     vkCmdEndRenderPass(getCurrentFrame().mainCommandBuffer);
+    if (getCurrentFrame().timestampPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(getCurrentFrame().mainCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, getCurrentFrame().timestampPool, 1);
+        getCurrentFrame().timestampsWritten = true;
+    }
     VK_CHECK(vkEndCommandBuffer(getCurrentFrame().mainCommandBuffer));
 
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
@@ -704,6 +1573,10 @@ void VulkanBackend::pushConstants(const void *data, size_t size, ShaderStage sta
     vkCmdPushConstants(getCurrentFrame().mainCommandBuffer, currentPipeline.pipelineLayout, convertShaderStageVulkan(stageFlags), 0, size, data);
 }
 
+void VulkanBackend::pushConstants(const void *data, size_t size, const std::vector<ShaderStage> &stages) {
+    vkCmdPushConstants(getCurrentFrame().mainCommandBuffer, currentPipeline.pipelineLayout, convertShaderStagesArrayVulkan(stages), 0, size, data);
+}
+
 VulkanBuffer VulkanBackend::createBuffer(size_t size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -719,28 +1592,69 @@ VulkanBuffer VulkanBackend::createBuffer(size_t size, VkBufferUsageFlags usage,
     return buffer;
 }
 
+VulkanBuffer VulkanBackend::uploadToGpuBuffer(const void *data, size_t size, VkBufferUsageFlags usage) {
+    return uploadToGpuBuffer(size, usage, [&](void *mapped) {
+        memcpy(mapped, data, size);
+    });
+}
+
+VulkanBuffer VulkanBackend::uploadToGpuBuffer(size_t size, VkBufferUsageFlags usage, const std::function<void(void *)> &fill) {
+    auto buffer = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+    uploadToBuffer(buffer, 0, size, fill);
+    return buffer;
+}
+
+void VulkanBackend::uploadToBuffer(const VulkanBuffer &buffer, VkDeviceSize offset, size_t size, const std::function<void(void *)> &fill) {
+    auto stagingBuffer = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    void *mapped;
+    vmaMapMemory(allocator, stagingBuffer.allocation, &mapped);
+    fill(mapped);
+    vmaUnmapMemory(allocator, stagingBuffer.allocation);
+
+    immediateSubmit([&](VkCommandBuffer commandBuffer) {
+        VkBufferCopy copyRegion = {};
+        copyRegion.size = size;
+        copyRegion.dstOffset = offset;
+        copyRegion.srcOffset = 0;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, buffer.buffer, 1, &copyRegion);
+    });
+
+    vmaDestroyBuffer(allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+}
+
 void VulkanBackend::createDescriptors(const Shader &pipelineShader) {
+    // every color pipeline gets a set with all textures, its shaders and the textures are known before the pipelines
+    uint32_t textureSetCount = 0;
+    for (auto &shader : shaders) {
+        if (!shader.second.depthOnly) {
+            textureSetCount++;
+        }
+    }
+    uint32_t textureCount = std::max(static_cast<uint32_t>(loadedTextures.size()), 1u);
     std::vector<VkDescriptorPoolSize> sizes ={{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10 },
                                               { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 10 },
-                                              { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10 }};
+                                              { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, std::max(textureSetCount, 1u) * textureCount },
+                                              { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * MESHLET_CULL_SET_COUNT }};
 
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.flags = 0;
-    pool_info.maxSets = 10;
+    pool_info.maxSets = FRAME_OVERLAP + textureSetCount + MESHLET_CULL_SET_COUNT;
     pool_info.poolSizeCount = (uint32_t)sizes.size();
     pool_info.pPoolSizes = sizes.data();
 
     vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptorPool);
 
     std::vector<VkDescriptorSetLayoutBinding> bindings;
+    // the tessellation stages of the terrain read the camera and the heightmap as well, its vertex stage the heightmap
+    VkShaderStageFlags tessellationStages = tessellationSupported ? VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT : 0;
 
     for (auto& uniform : pipelineShader.descriptorBinding.uniforms) {
         VkDescriptorSetLayoutBinding binding{};
         binding.binding = uniform.binding;
         binding.descriptorType = getDescriptorTypeFromUniformType(uniform.type);
         binding.descriptorCount = 1;
-        binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | tessellationStages;
         binding.pImmutableSamplers = nullptr;
         bindings.push_back(binding);
     }
@@ -806,7 +1720,7 @@ void VulkanBackend::createDescriptors(const Shader &pipelineShader) {
         textureBind->binding = i;
         textureBind->descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         textureBind->descriptorCount = 1;
-        textureBind->stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        textureBind->stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | tessellationStages;
         textureBind->pImmutableSamplers = nullptr;
         textureBindings.push_back(*textureBind);
     }
@@ -877,87 +1791,531 @@ VkSubmitInfo VulkanBackend::createSubmitInfo(VkCommandBuffer *cmd) {
     return info;
 }
 
-// TODO: mem leak somewhere here
-void VulkanBackend::addTexture(const Texture &texture, uint32_t binding) {
-    void *pixels = texture.data;
-    VkDeviceSize imageSize = texture.width * texture.height * 4;
+VulkanBuffer VulkanBackend::createTextureStaging(const Texture &texture) {
+    VkDeviceSize imageSize = TextureCooker::getMipChainSize(texture.width, texture.height, texture.layers, texture.mipLevels, texture.format);
     auto stagingBuffer = createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
     void *data;
     vmaMapMemory(allocator, stagingBuffer.allocation, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    memcpy(data, texture.data, static_cast<size_t>(imageSize));
     vmaUnmapMemory(allocator, stagingBuffer.allocation);
+    return stagingBuffer;
+}
 
+VulkanTexture VulkanBackend::createTextureImage(const Texture &texture, uint32_t binding) {
     VkExtent3D imageExtent;
     imageExtent.width = static_cast<uint32_t>(texture.width);
     imageExtent.height = static_cast<uint32_t>(texture.height);
     imageExtent.depth = 1;
 
-    VkImageCreateInfo dimageInfo = createImageInfo(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, imageExtent);
-
-    AllocatedImage *newImage = new AllocatedImage();
+    if (TextureCompressor::isBlockCompressed(texture.format) && !textureCompressionBCSupported) {
+        throw std::runtime_error("Texture " + std::string(texture.name) + " is block compressed, the device can't sample BCn");
+    }
+    VkFormat format = getTextureFormat(texture);
+    // cooked textures bring their whole chain
+    uint32_t mipLevels = texture.mipLevels;
+    if (texture.mipmaps && texture.mipLevels == 1) {
+        mipLevels = TextureCooker::getMipLevelCount(texture.width, texture.height);
+        // the levels are blitted from each other with linear filtering, without it the texture keeps one level
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+        VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if ((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures) {
+            std::cout << "Format of texture " << texture.name << " has no linear blit, mipmaps are not generated" << std::endl;
+            mipLevels = 1;
+        }
+    }
+    // a source for the blits of the generated levels and for the image that replaces a streamed texture
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImageCreateInfo dimageInfo = createImageInfo(format, usage, imageExtent, mipLevels);
+    dimageInfo.arrayLayers = texture.layers;
 
     VmaAllocationCreateInfo dimgAllocInfo = {};
     dimgAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
-    vmaCreateImage(allocator, &dimageInfo, &dimgAllocInfo, &newImage->image, &newImage->allocation, nullptr);
-    //delete texture.data;
-    immediateSubmit([&](VkCommandBuffer cmd) {
-        VkImageSubresourceRange range;
-        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        range.baseMipLevel = 0;
-        range.levelCount = 1;
-        range.baseArrayLayer = 0;
-        range.layerCount = 1;
-
-        VkImageMemoryBarrier imageBarrier_toTransfer = {};
-        imageBarrier_toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-
-        imageBarrier_toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageBarrier_toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageBarrier_toTransfer.image = newImage->image;
-        imageBarrier_toTransfer.subresourceRange = range;
-
-        imageBarrier_toTransfer.srcAccessMask = 0;
-        imageBarrier_toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toTransfer);
+    VulkanTexture resTexture{};
+    vmaCreateImage(allocator, &dimageInfo, &dimgAllocInfo, &resTexture.image.image, &resTexture.image.allocation, nullptr);
+    resTexture.texture = texture;
+    resTexture.binding = binding;
+    resTexture.mipLevels = mipLevels;
+    VkImageViewCreateInfo imageInfo = createImageViewInfo(format, resTexture.image.image, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+    if (texture.layers > 1) {
+        imageInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        imageInfo.subresourceRange.layerCount = texture.layers;
+    }
+    vkCreateImageView(device, &imageInfo, nullptr, &resTexture.imageView);
+    return resTexture;
+}
 
-        VkBufferImageCopy copyRegion = {};
-        copyRegion.bufferOffset = 0;
+void VulkanBackend::recordTextureUpload(VkCommandBuffer cmd, const VulkanTexture &resTexture, const VulkanBuffer &stagingBuffer, uint32_t stagedLevels,
+                                        const VulkanTexture *resident, uint32_t residentLevel) {
+    const Texture &texture = resTexture.texture;
+    uint32_t mipLevels = resTexture.mipLevels;
+    bool blitLevels = mipLevels > texture.mipLevels;
+    stagedLevels = resident ? std::min(stagedLevels, texture.mipLevels) : texture.mipLevels;
+    // the texture says nothing about which stages sample it, any shader of any material may
+    const VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+
+    VkImageSubresourceRange range;
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = mipLevels;
+    range.baseArrayLayer = 0;
+    range.layerCount = texture.layers;
+
+    VkImageMemoryBarrier imageBarrier_toTransfer = {};
+    imageBarrier_toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+
+    imageBarrier_toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageBarrier_toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    imageBarrier_toTransfer.image = resTexture.image.image;
+    imageBarrier_toTransfer.subresourceRange = range;
+
+    imageBarrier_toTransfer.srcAccessMask = 0;
+    imageBarrier_toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toTransfer);
+
+    // one region for every level in the staging buffer, levels of block compressed textures take whole blocks
+    // while their extent stays the size of the level
+    std::vector<VkBufferImageCopy> copyRegions(stagedLevels);
+    for (uint32_t level = 0; level < stagedLevels; level++) {
+        VkBufferImageCopy &copyRegion = copyRegions[level];
+        copyRegion.bufferOffset = TextureCooker::getMipChainSize(texture.width, texture.height, texture.layers, level, texture.format);
         copyRegion.bufferRowLength = 0;
         copyRegion.bufferImageHeight = 0;
 
         copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copyRegion.imageSubresource.mipLevel = 0;
+        copyRegion.imageSubresource.mipLevel = level;
         copyRegion.imageSubresource.baseArrayLayer = 0;
-        copyRegion.imageSubresource.layerCount = 1;
-        copyRegion.imageExtent = imageExtent;
+        copyRegion.imageSubresource.layerCount = texture.layers;
+        copyRegion.imageOffset = {0, 0, 0};
+        copyRegion.imageExtent = {std::max(uint32_t(texture.width) >> level, 1u), std::max(uint32_t(texture.height) >> level, 1u), 1};
+    }
 
-        //copy the buffer into the image
-        vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, newImage->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+    //copy the buffer into the image
+    if (!copyRegions.empty()) {
+        vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, resTexture.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(copyRegions.size()), copyRegions.data());
+    }
 
-        VkImageMemoryBarrier imageBarrier_toReadable = imageBarrier_toTransfer;
+    // the levels the replaced image already holds are copied on the GPU instead of being staged again. It is sampled
+    // until the new image is resident, so it goes back to the shader readable layout afterwards
+    if (stagedLevels < texture.mipLevels) {
+        VkImageMemoryBarrier residentBarrier = {};
+        residentBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        residentBarrier.image = resident->image.image;
+        residentBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, residentLevel, texture.mipLevels - stagedLevels, 0, texture.layers};
+        residentBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        residentBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        residentBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        residentBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, readStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &residentBarrier);
+
+        std::vector<VkImageCopy> imageCopies(texture.mipLevels - stagedLevels);
+        for (uint32_t level = stagedLevels; level < texture.mipLevels; level++) {
+            VkImageCopy &imageCopy = imageCopies[level - stagedLevels];
+            imageCopy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, residentLevel + level - stagedLevels, 0, texture.layers};
+            imageCopy.srcOffset = {0, 0, 0};
+            imageCopy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, texture.layers};
+            imageCopy.dstOffset = {0, 0, 0};
+            imageCopy.extent = {std::max(uint32_t(texture.width) >> level, 1u), std::max(uint32_t(texture.height) >> level, 1u), 1};
+        }
+        vkCmdCopyImage(cmd, resident->image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, resTexture.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       uint32_t(imageCopies.size()), imageCopies.data());
+
+        residentBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        residentBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        residentBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        residentBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 0, nullptr, 0, nullptr, 1, &residentBarrier);
+    }
+
+    // every level is blitted from the one above it, which moves to the transfer source layout first and is
+    // readable by the shaders once the blit is done. blits of sRGB levels filter in linear space
+    VkImageMemoryBarrier levelBarrier = imageBarrier_toTransfer;
+    levelBarrier.subresourceRange.levelCount = 1;
+    int32_t levelWidth = texture.width;
+    int32_t levelHeight = texture.height;
+    for (uint32_t level = 1; blitLevels && level < mipLevels; level++) {
+        levelBarrier.subresourceRange.baseMipLevel = level - 1;
+        levelBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        levelBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        levelBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        levelBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+
+        VkImageBlit blit = {};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, texture.layers};
+        blit.srcOffsets[1] = {levelWidth, levelHeight, 1};
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, texture.layers};
+        blit.dstOffsets[1] = {levelWidth, levelHeight, 1};
+        vkCmdBlitImage(cmd, resTexture.image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, resTexture.image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        levelBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        levelBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        levelBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+    }
 
-        imageBarrier_toReadable.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageBarrier_toReadable.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkImageMemoryBarrier imageBarrier_toReadable = imageBarrier_toTransfer;
+    // after the blits only the last level is still a transfer destination
+    if (blitLevels) {
+        imageBarrier_toReadable.subresourceRange.baseMipLevel = mipLevels - 1;
+        imageBarrier_toReadable.subresourceRange.levelCount = 1;
+    }
+
+    imageBarrier_toReadable.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    imageBarrier_toReadable.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-        imageBarrier_toReadable.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageBarrier_toReadable.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    imageBarrier_toReadable.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    imageBarrier_toReadable.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        //barrier the image into the shader readable layout
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toReadable);
+    //barrier the image into the shader readable layout
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toReadable);
+}
+
+void VulkanBackend::storeTexture(const std::string &name, VulkanTexture resTexture) {
+    auto stored = loadedTextures.find(name);
+    // an image that is still alive already has the destruction of its texture queued
+    bool queued = stored != loadedTextures.end() && stored->second.image.image != VK_NULL_HANDLE;
+    if (queued) {
+        vmaDestroyImage(allocator, stored->second.image.image, stored->second.image.allocation);
+        vkDestroyImageView(device, stored->second.imageView, nullptr);
+    }
+    stored = loadedTextures.insert_or_assign(name, std::move(resTexture)).first;
+    // the map key outlives the name the texture was added with
+    stored->second.texture.name = stored->first.c_str();
+    if (queued) {
+        return;
+    }
+    // destroyed here rather than with the pipelines, every pipeline samples the same textures
+    deletionQueue.push_function([=, this]() {
+        auto &texture = loadedTextures[name];
+        vmaDestroyImage(allocator, texture.image.image, texture.image.allocation);
+        vkDestroyImageView(device, texture.imageView, nullptr);
+        texture.image.image = VK_NULL_HANDLE;
+        std::cout << "Destroyed texture " << name << std::endl;
     });
+}
 
+// TODO: mem leak somewhere here
+void VulkanBackend::addTexture(const Texture &texture, uint32_t binding) {
+    auto stagingBuffer = createTextureStaging(texture);
+    auto resTexture = createTextureImage(texture, binding);
+    immediateSubmit([&](VkCommandBuffer cmd) {
+        recordTextureUpload(cmd, resTexture, stagingBuffer);
+    });
     vmaDestroyBuffer(allocator, stagingBuffer.buffer, stagingBuffer.allocation);
-    VulkanTexture resTexture{};
-    resTexture.texture = texture;
-    resTexture.image = *newImage;
-    // TODO: do we need it?
-    delete newImage;
-    resTexture.binding = binding;
-    VkImageViewCreateInfo imageInfo = createImageViewInfo(VK_FORMAT_R8G8B8A8_SRGB, resTexture.image.image, VK_IMAGE_ASPECT_COLOR_BIT);
-    vkCreateImageView(device, &imageInfo, nullptr, &resTexture.imageView);
-    loadedTextures[texture.name] = resTexture;
+    storeTexture(texture.name, std::move(resTexture));
+}
+
+void VulkanBackend::loadTextureAsync(const Texture &texture, const std::string &path, uint32_t binding, bool streamed) {
+    // mid grey until the image is resident, never written
+    static unsigned char placeholderTexel[4] = {128, 128, 128, 255};
+    Texture placeholder = texture;
+    placeholder.width = 1;
+    placeholder.height = 1;
+    placeholder.nrChannels = 4;
+    placeholder.layers = 1;
+    placeholder.mipmaps = false;
+    placeholder.mipLevels = 1;
+    placeholder.format = TextureFormat::RGBA8;
+    placeholder.data = placeholderTexel;
+    placeholder.cookedData.reset();
+    placeholder.cookedFile.reset();
+    addTexture(placeholder, binding);
+
+    auto &upload = textureUploads.emplace_back();
+    upload.texture = texture.name;
+    upload.binding = binding;
+    upload.source = texture;
+    upload.streamed = streamed;
+    upload.start = std::chrono::steady_clock::now();
+    // the worker only touches the upload, which stays in place in the list until its future is consumed
+    upload.loaded = ThreadPool::global().submit([this, &upload, path]() {
+        upload.source.loadTextureFromFile(path.c_str());
+        if (!upload.source.data) {
+            return false;
+        }
+        // only cooked chains can be streamed, the first upload takes their tail
+        upload.streamed = upload.streamed && upload.source.mipLevels > 1;
+        if (upload.streamed) {
+            upload.chain = upload.source;
+            upload.firstLevel = getTailLevel(upload.chain, TEXTURE_TAIL_SIZE);
+            upload.source = upload.chain.getLevels(upload.firstLevel);
+        }
+        upload.staging = createTextureStaging(upload.source);
+        return true;
+    });
+}
+
+void VulkanBackend::startTextureUpload(const std::string &name, uint32_t firstLevel) {
+    auto &streamed = streamedTextures[name];
+    streamed.uploading = true;
+    auto &upload = textureUploads.emplace_back();
+    upload.texture = name;
+    upload.binding = streamed.binding;
+    upload.source = streamed.chain.getLevels(firstLevel);
+    upload.firstLevel = firstLevel;
+    upload.streamed = true;
+    // only the levels finer than the resident ones are staged, the rest are in the image already
+    upload.stagedLevels = firstLevel < streamed.residentLevel ? streamed.residentLevel - firstLevel : 0;
+    upload.residentLevel = firstLevel + upload.stagedLevels - streamed.residentLevel;
+    upload.start = std::chrono::steady_clock::now();
+    // the levels are mapped from the cache, reading them may fault them in from disk
+    upload.loaded = ThreadPool::global().submit([this, &upload]() {
+        if (upload.stagedLevels > 0) {
+            Texture staged = upload.source;
+            staged.mipLevels = upload.stagedLevels;
+            upload.staging = createTextureStaging(staged);
+        }
+        return true;
+    });
+}
+
+void VulkanBackend::requestTextureDetail(const std::string &name, float texelsAcross) {
+    auto streamed = streamedTextures.find(name);
+    if (streamed == streamedTextures.end() || texelsAcross <= 0.0f) {
+        return;
+    }
+    // the level with about as many texels as the screen shows
+    auto size = float(std::max(streamed->second.chain.width, streamed->second.chain.height));
+    uint32_t level = texelsAcross >= size ? 0 : static_cast<uint32_t>(std::log2(size / texelsAcross));
+    level = std::min(level, streamed->second.tailLevel);
+    streamed->second.requestedLevel = std::min(streamed->second.requestedLevel, level);
+}
+
+VkDeviceSize VulkanBackend::getStreamingBudget() {
+    const VkPhysicalDeviceMemoryProperties *memoryProperties;
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+    // images go to the largest device local heap
+    uint32_t heap = UINT32_MAX;
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++) {
+        if ((memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) &&
+            (heap == UINT32_MAX || memoryProperties->memoryHeaps[i].size > memoryProperties->memoryHeaps[heap].size)) {
+            heap = i;
+        }
+    }
+    if (heap == UINT32_MAX) {
+        return textureBudget;
+    }
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator, budgets);
+    // what the streamed textures hold now, including the images of their pending uploads, is theirs to keep
+    VkDeviceSize streamedBytes = 0;
+    for (const auto &streamed : streamedTextures) {
+        streamedBytes += getLevelsSize(streamed.second.chain, streamed.second.residentLevel);
+    }
+    for (const auto &upload : textureUploads) {
+        if (upload.streamed && upload.resident.image.image != VK_NULL_HANDLE) {
+            streamedBytes += getLevelsSize(upload.source, 0);
+        }
+    }
+    VkDeviceSize available = budgets[heap].budget > budgets[heap].usage ? budgets[heap].budget - budgets[heap].usage : 0;
+    return std::min(textureBudget, available + streamedBytes);
+}
+
+void VulkanBackend::updateTextureStreaming() {
+    if (streamedTextures.empty()) {
+        return;
+    }
+    // finer levels are taken right away, coarser ones only once the finer ones have not been needed for a while
+    for (auto &entry : streamedTextures) {
+        auto &streamed = entry.second;
+        if (streamed.requestedLevel != UINT32_MAX) {
+            streamed.lastUsed = frameNumber;
+            if (streamed.requestedLevel <= streamed.wantedLevel || streamed.levelFrame + TEXTURE_KEEP_FRAMES < frameNumber) {
+                streamed.wantedLevel = streamed.requestedLevel;
+                streamed.levelFrame = frameNumber;
+            }
+        }
+        else if (streamed.lastUsed + TEXTURE_KEEP_FRAMES < frameNumber) {
+            streamed.wantedLevel = streamed.tailLevel;
+        }
+        streamed.requestedLevel = UINT32_MAX;
+    }
+
+    struct Residency {
+        const std::string *name;
+        StreamedTexture *texture;
+        uint32_t level;
+    };
+    std::vector<Residency> residency;
+    VkDeviceSize total = 0;
+    for (auto &entry : streamedTextures) {
+        residency.push_back({&entry.first, &entry.second, entry.second.wantedLevel});
+        total += getLevelsSize(entry.second.chain, entry.second.wantedLevel);
+    }
+    // over the budget the least recently used texture gives up its finest level, the largest one among those used
+    // in the same frame, until everything fits or only tails are left
+    VkDeviceSize budget = getStreamingBudget();
+    while (total > budget) {
+        Residency *evicted = nullptr;
+        VkDeviceSize evictedSize = 0;
+        for (auto &entry : residency) {
+            if (entry.level >= entry.texture->tailLevel) {
+                continue;
+            }
+            VkDeviceSize size = getLevelsSize(entry.texture->chain, entry.level);
+            if (!evicted || entry.texture->lastUsed < evicted->texture->lastUsed ||
+                (entry.texture->lastUsed == evicted->texture->lastUsed && size > evictedSize)) {
+                evicted = &entry;
+                evictedSize = size;
+            }
+        }
+        if (!evicted) {
+            break;
+        }
+        evicted->level++;
+        total -= evictedSize - getLevelsSize(evicted->texture->chain, evicted->level);
+    }
+    // while an upload is in flight the image it replaces is still resident, so what the images hold now counts
+    // against the budget too. Textures dropping levels go first, the ones gaining levels start once both images fit
+    VkDeviceSize used = 0;
+    for (const auto &entry : streamedTextures) {
+        used += getLevelsSize(entry.second.chain, entry.second.residentLevel);
+    }
+    for (const auto &upload : textureUploads) {
+        if (upload.streamed) {
+            used += getLevelsSize(upload.source, 0);
+        }
+    }
+    for (bool finer : {false, true}) {
+        for (auto &entry : residency) {
+            if (entry.texture->uploading || entry.level == entry.texture->residentLevel || (entry.level < entry.texture->residentLevel) != finer) {
+                continue;
+            }
+            VkDeviceSize size = getLevelsSize(entry.texture->chain, entry.level);
+            if (finer && used + size > budget) {
+                continue;
+            }
+            startTextureUpload(*entry.name, entry.level);
+            used += size;
+        }
+    }
+}
+
+void VulkanBackend::updateTextureUploads() {
+    for (auto upload = textureUploads.begin(); upload != textureUploads.end();) {
+        if (upload->loaded.valid()) {
+            if (upload->loaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++upload;
+                continue;
+            }
+            bool loaded = false;
+            std::string error = "cannot read the file";
+            try {
+                loaded = upload->loaded.get();
+            }
+            catch (const std::exception &e) {
+                error = e.what();
+            }
+            if (loaded) {
+                try {
+                    upload->resident = createTextureImage(upload->source, upload->binding);
+                }
+                catch (const std::exception &e) {
+                    loaded = false;
+                    error = e.what();
+                }
+            }
+            if (!loaded) {
+                // the placeholder or the levels resident before stay
+                std::cout << "Failed to load texture " << upload->texture << ": " << error << std::endl;
+                auto streamed = streamedTextures.find(upload->texture);
+                if (upload->streamed && streamed != streamedTextures.end()) {
+                    streamed->second.uploading = false;
+                }
+                if (upload->staging.buffer != VK_NULL_HANDLE) {
+                    vmaDestroyBuffer(allocator, upload->staging.buffer, upload->staging.allocation);
+                }
+                upload = textureUploads.erase(upload);
+                continue;
+            }
+        }
+        if (!upload->recorded || upload->lastFrame + FRAME_OVERLAP > frameNumber) {
+            ++upload;
+            continue;
+        }
+        // the copies are done and no frame is in flight here, so the image it replaces can go and the descriptor sets
+        // can be rewritten
+        storeTexture(upload->texture, upload->resident);
+        if (upload->streamed) {
+            auto &streamed = streamedTextures[upload->texture];
+            // the first upload of a streamed texture brings its chain
+            if (!streamed.chain.data) {
+                streamed.chain = std::move(upload->chain);
+                streamed.binding = upload->binding;
+                streamed.tailLevel = upload->firstLevel;
+                streamed.wantedLevel = upload->firstLevel;
+                streamed.lastUsed = frameNumber;
+                streamed.levelFrame = frameNumber;
+            }
+            streamed.residentLevel = upload->firstLevel;
+            streamed.uploading = false;
+        }
+        auto &stored = loadedTextures[upload->texture];
+        VkSampler sampler = getTextureSampler(stored);
+        for (auto &material : materials) {
+            if (material.second.textureSet == VK_NULL_HANDLE) {
+                continue;
+            }
+            VkDescriptorImageInfo imageInfo = {};
+            imageInfo.sampler = sampler;
+            imageInfo.imageView = stored.imageView;
+            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            auto write = createWriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, material.second.textureSet, &imageInfo, stored.binding);
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        }
+        vmaDestroyBuffer(allocator, upload->staging.buffer, upload->staging.allocation);
+        std::cout << "Streamed texture " << upload->texture << ": " << stored.texture.width << "x" << stored.texture.height << ", " << stored.mipLevels << " levels in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - upload->start).count() << " ms" << std::endl;
+        upload = textureUploads.erase(upload);
+    }
+}
+
+void VulkanBackend::recordTextureUploads() {
+    auto cmd = getCurrentFrame().mainCommandBuffer;
+    VkDeviceSize budget = TEXTURE_LOAD_BUDGET;
+    for (auto &upload : textureUploads) {
+        if (upload.loaded.valid() || upload.recorded) {
+            continue;
+        }
+        // a texture larger than the budget still goes, alone in its frame. Levels copied from the replaced image are
+        // not staged and cost nothing here
+        uint32_t stagedLevels = std::min(upload.stagedLevels, upload.source.mipLevels);
+        VkDeviceSize size = TextureCooker::getMipChainSize(upload.source.width, upload.source.height, upload.source.layers, stagedLevels, upload.source.format);
+        if (size > budget && budget < TEXTURE_LOAD_BUDGET) {
+            break;
+        }
+        const VulkanTexture *resident = nullptr;
+        if (stagedLevels < upload.source.mipLevels) {
+            resident = &loadedTextures.at(upload.texture);
+        }
+        recordTextureUpload(cmd, upload.resident, upload.staging, upload.stagedLevels, resident, upload.residentLevel);
+        upload.recorded = true;
+        upload.lastFrame = frameNumber;
+        budget -= std::min(size, budget);
+    }
+}
+
+VkSampler VulkanBackend::getTextureSampler(const VulkanTexture &texture) {
+    uint32_t index = texture.mipLevels > 1 ? 1 : 0;
+    if (textureSamplers[index] == VK_NULL_HANDLE) {
+        VkSamplerCreateInfo samplerInfo = createSamplerCreateInfo(VK_FILTER_NEAREST);
+        // magnified texels stay blocky, minified ones are filtered across the mip chain
+        if (index == 1) {
+            samplerInfo.minFilter = VK_FILTER_LINEAR;
+        }
+        vkCreateSampler(device, &samplerInfo, nullptr, &textureSamplers[index]);
+        deletionQueue.push_function([=, this]() {
+            vkDestroySampler(device, textureSamplers[index], nullptr);
+            textureSamplers[index] = VK_NULL_HANDLE;
+        });
+    }
+    return textureSamplers[index];
 }
 
 VkSamplerCreateInfo VulkanBackend::createSamplerCreateInfo(VkFilter filters, VkSamplerAddressMode samplerAddressMode) {
@@ -969,6 +2327,9 @@ VkSamplerCreateInfo VulkanBackend::createSamplerCreateInfo(VkFilter filters, VkS
     info.addressModeU = samplerAddressMode;
     info.addressModeV = samplerAddressMode;
     info.addressModeW = samplerAddressMode;
+    info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    info.minLod = 0.0f;
+    info.maxLod = VK_LOD_CLAMP_NONE;
     return info;
 }
 
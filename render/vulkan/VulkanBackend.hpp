@@ -14,8 +14,11 @@
 #include <stdexcept>
 #include <iostream>
 #include <memory>
+#include <chrono>
 #include <deque>
 #include <functional>
+#include <future>
+#include <list>
 #include "GLFW/glfw3.h"
 #include "glm/glm.hpp"
 #include <glm/ext.hpp>
@@ -71,6 +74,20 @@ struct FrameData {
     std::map<std::string, VulkanBuffer> uniformBuffers;
     //VulkanBuffer uniformBuffer;
     VkDescriptorSet globalDescriptorSet;
+
+    // per-instance vertex data written while recording, bound at binding 1 of instanced draws. Mapped for as long as
+    // it lives, the frame grows it once its fence has signalled when the last use needed more
+    VulkanBuffer instanceBuffer;
+    void *instanceBufferMapped = nullptr;
+    VkDeviceSize instanceBufferSize = 0;
+    VkDeviceSize instanceBufferUsed = 0;
+    VkDeviceSize instanceBufferNeeded = 0;
+    // staging for the texture updates recorded in the frame
+    VulkanBuffer textureUploadBuffer;
+    VkDeviceSize textureUploadUsed = 0;
+    // timestamps at the start and the end of the command buffer, read back once the fence has signalled
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    bool timestampsWritten = false;
 };
 
 struct UploadContext {
@@ -79,11 +96,85 @@ struct UploadContext {
     VkCommandBuffer commandBuffer;
 };
 
+// Mesh read on a worker thread into a staging buffer, then copied into its buffers over the following frames
+struct MeshUpload {
+    std::string mesh;
+    std::future<bool> loaded;
+    Mesh source;
+    MeshStagingLayout layout;
+    VulkanBuffer staging;
+    uint64_t contentHash = 0;
+    std::vector<MeshBufferCopy> copies;
+    size_t nextCopy = 0;
+    // bytes of copies[nextCopy] that are already recorded
+    VkDeviceSize copiedBytes = 0;
+    // frame that recorded the last copy, the mesh is ready once its fence has signalled
+    uint64_t lastFrame = 0;
+    // the mesh was released before it finished loading
+    bool cancelled = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Rectangle of one layer of a texture, data points at its first texel and rows of data are rowLength texels apart
+struct TextureRegion {
+    uint32_t layer = 0;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const uint8_t *data = nullptr;
+    uint32_t rowLength = 0;
+};
+
 struct VulkanTexture {
     AllocatedImage image;
     VkImageView imageView;
     Texture texture;
     uint32_t binding;
+    uint32_t mipLevels = 1;
+};
+
+// Texture decoded or mapped from its cache on a worker thread into a staging buffer, its placeholder is sampled until
+// the copy recorded in a frame has finished
+struct TextureUpload {
+    std::string texture;
+    uint32_t binding = 0;
+    std::future<bool> loaded;
+    Texture source;
+    VulkanBuffer staging;
+    // created once loading finished, moved into loadedTextures when it is resident
+    VulkanTexture resident{};
+    // source starts at this level of a streamed texture
+    uint32_t firstLevel = 0;
+    // levels of source in the staging buffer, the ones after them are copied from the image of the texture it replaces,
+    // which holds the first of them at residentLevel
+    uint32_t stagedLevels = UINT32_MAX;
+    uint32_t residentLevel = 0;
+    bool streamed = false;
+    // every level of a streamed texture when it is loaded, source is the part of it that is uploaded first
+    Texture chain;
+    bool recorded = false;
+    // frame that recorded the copy
+    uint64_t lastFrame = 0;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Texture whose finer levels are only resident while they are needed, the whole chain stays mapped from its cache
+struct StreamedTexture {
+    Texture chain;
+    uint32_t binding = 0;
+    // coarsest level that is always resident
+    uint32_t tailLevel = 0;
+    // largest level in the image
+    uint32_t residentLevel = 0;
+    // level the requests settled on, kept for a while after they ask for less
+    uint32_t wantedLevel = 0;
+    // finest level requested since the last update
+    uint32_t requestedLevel = UINT32_MAX;
+    // frames of the last request and of the last time wantedLevel was needed
+    uint64_t lastUsed = 0;
+    uint64_t levelFrame = 0;
+    bool uploading = false;
 };
 
 class VulkanBackend {
@@ -133,6 +224,120 @@ private:
 
     UploadContext uploadContext;
 
+    bool multiDrawIndirectSupported = false;
+    bool tessellationSupported = false;
+    bool textureCompressionBCSupported = false;
+    // the instance can query extended device properties, which the memory budget extension needs
+    bool physicalDeviceProperties2Supported = false;
+    // the heap budgets come from the driver, otherwise VMA estimates them
+    bool memoryBudgetSupported = false;
+    // the graphics queue writes timestamps, which time the frames on the GPU
+    bool timestampsSupported = false;
+
+    Shader meshletCullShader;
+    VkDescriptorSetLayout meshletCullSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout meshletCullPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline meshletCullPipeline = VK_NULL_HANDLE;
+
+    // meshes whose last instance was removed, destroyed once the frames that may still draw them have finished
+    std::vector<std::pair<uint64_t, VulkanMesh>> releasedMeshes;
+    // names of streamed meshes that turned out to have the content of another mesh, and the mesh they resolve to
+    std::unordered_map<std::string, std::string> meshAliases;
+    uint32_t nextInstanceId = 0;
+    bool meshesLoaded = false;
+
+    // every mesh is a range of the vertex pool of its layout and of the index pool of its index type
+    static constexpr uint32_t GEOMETRY_POOL_MIN_CAPACITY = 1u << 20;
+    VulkanGeometryPool vertexPools[3];
+    VulkanGeometryPool indexPools[2];
+    // pools bound in the current command buffer, draws only rebind when a mesh lives in another one
+    const VulkanGeometryPool *boundVertexPool = nullptr;
+    bool boundPositions = false;
+    const VulkanGeometryPool *boundIndexPool = nullptr;
+    // copies out of pool buffers that were replaced, and the replaced buffers with the frame that last read them
+    std::vector<GeometryPoolCopy> geometryPoolCopies;
+    std::vector<std::pair<uint64_t, VulkanBuffer>> retiredPoolBuffers;
+
+    void destroyMesh(VulkanMesh &mesh);
+    VulkanGeometryPool &getVertexPool(const VulkanMesh &mesh) { return vertexPools[static_cast<uint32_t>(mesh.vertexLayout)]; }
+    VulkanGeometryPool &getIndexPool(const VulkanMesh &mesh) { return indexPools[mesh.indexType == VK_INDEX_TYPE_UINT16 ? 0 : 1]; }
+    // range of count elements, the pool buffers are created or grown when it does not fit
+    uint32_t allocateGeometry(VulkanGeometryPool &pool, uint32_t count, VkBufferUsageFlags usage, bool positions);
+    void growGeometryPool(VulkanGeometryPool &pool, uint32_t capacity, VkBufferUsageFlags usage, bool positions);
+    void destroyGeometryPool(VulkanGeometryPool &pool);
+    // record the pending pool copies ahead of any copy into the grown buffers and retire their sources
+    void recordGeometryPoolCopies(VkCommandBuffer cmd);
+    void bindGeometry(const VulkanMesh &mesh, bool depthOnly);
+    // create the instance buffer of frame, or a larger one when its last use ran out of room
+    void reserveInstanceBuffer(FrameData &frame);
+
+    // bytes of mesh data copied per frame, larger uploads are spread over several frames
+    static constexpr VkDeviceSize MESH_UPLOAD_BUDGET = 16ull << 20;
+    // instance data a frame starts with, it doubles when a frame needs more
+    static constexpr VkDeviceSize INSTANCE_BUFFER_SIZE = 1ull << 20;
+    // meshes that can get a meshlet cull set, the others are culled on the CPU
+    static constexpr uint32_t MESHLET_CULL_SET_COUNT = 64;
+    // texel bytes a frame can update
+    static constexpr VkDeviceSize TEXTURE_UPLOAD_BUDGET = 4ull << 20;
+
+    // bytes of loaded textures copied per frame, a larger texture is copied alone
+    static constexpr VkDeviceSize TEXTURE_LOAD_BUDGET = 64ull << 20;
+    // streamed textures keep the levels up to this size resident
+    static constexpr uint32_t TEXTURE_TAIL_SIZE = 128;
+    // frames a streamed texture keeps its finer levels after the last request that needed them
+    static constexpr uint64_t TEXTURE_KEEP_FRAMES = 120;
+
+    // list so that the workers can write into an upload while others are added
+    std::list<MeshUpload> meshUploads;
+    std::list<TextureUpload> textureUploads;
+    std::unordered_map<std::string, StreamedTexture> streamedTextures;
+    // bytes the streamed textures may take in VRAM
+    VkDeviceSize textureBudget = 256ull << 20;
+    // samplers of textures without and with mipmaps, shared by every texture
+    VkSampler textureSamplers[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+    // name of a mesh whose streams, written out in its layout, are the bytes of data and whose lods are those of mesh,
+    // empty if there is none
+    std::string findMeshWithStreams(const Mesh &mesh, const MeshStagingLayout &layout, const void *data, uint64_t contentHash);
+    // move the instances of the mesh still loading under name to target and resolve name to target from now on
+    void aliasMesh(const std::string &name, const std::string &target);
+    // allocate the geometry ranges and buffers of mesh, returns the copies that fill them from a staging buffer in layout
+    std::vector<MeshBufferCopy> allocateMeshGeometry(VulkanMesh &mesh, const MeshStagingLayout &layout);
+    // record copies starting at nextCopy until budget bytes are recorded, advances nextCopy, copiedBytes and budget
+    void recordMeshCopies(VkCommandBuffer cmd, const VulkanMesh &mesh, const VulkanBuffer &staging, const std::vector<MeshBufferCopy> &copies,
+                          size_t &nextCopy, VkDeviceSize &copiedBytes, VkDeviceSize &budget);
+    // write the source of upload into a new staging buffer on a worker, leaves none behind when its cache does not decode
+    void stageMeshUpload(MeshUpload &upload);
+    // start the uploads whose loading finished and make the meshes of the completed ones drawable
+    void updateMeshUploads();
+    // record this frame's share of the pending uploads
+    void recordMeshUploads();
+
+    // staging buffer with the texels of texture, safe to call from the workers
+    VulkanBuffer createTextureStaging(const Texture &texture);
+    // image and view of texture with the levels the backend gives it, nothing is uploaded yet
+    VulkanTexture createTextureImage(const Texture &texture, uint32_t binding);
+    // copy the staging buffer into the first stagedLevels levels of the image and the levels after them from resident
+    // starting at its residentLevel, blit the levels the texture does not bring and make it readable
+    void recordTextureUpload(VkCommandBuffer cmd, const VulkanTexture &resTexture, const VulkanBuffer &stagingBuffer, uint32_t stagedLevels = UINT32_MAX,
+                             const VulkanTexture *resident = nullptr, uint32_t residentLevel = 0);
+    // the image of a texture it replaces is destroyed right away and must not be in use, the last one is destroyed
+    // with the deletion queue
+    void storeTexture(const std::string &name, VulkanTexture resTexture);
+    VkSampler getTextureSampler(const VulkanTexture &texture);
+    // copy the levels of a streamed texture from firstLevel on into a staging buffer on a worker
+    void startTextureUpload(const std::string &name, uint32_t firstLevel);
+    // VRAM left for the streamed textures, the smaller of textureBudget and what the device local heap has left
+    VkDeviceSize getStreamingBudget();
+    // settle the levels the streamed textures want, drop levels of the least recently used ones until they fit into
+    // the budget and start the uploads of those that change
+    void updateTextureStreaming();
+    // create the images of the loaded textures and point the materials at the resident ones
+    void updateTextureUploads();
+    // record copies of the loaded textures up to the budget
+    void recordTextureUploads();
+    void createMeshletCullSet(VulkanMesh &mesh);
+
     static VkDescriptorType getDescriptorTypeFromUniformType(UniformType type) {
         switch (type) {
             case UniformType::UNIFORM_BUFFER:
@@ -157,7 +362,10 @@ private:
     }
 
 public:
+    static constexpr uint32_t NO_DRAW_SLOT = UINT32_MAX;
     bool isInitialized = false;
+    bool isTessellationSupported() const { return tessellationSupported; }
+    bool isTextureCompressionBCSupported() const { return textureCompressionBCSupported; }
     VkDeviceSize getBufferAlignedSize(VkDeviceSize size) const {
         VkDeviceSize minAlignment = gpuProperties.limits.minUniformBufferOffsetAlignment;
         size_t alignedSize = size;
@@ -168,25 +376,58 @@ public:
     };
 
     uint64_t frameNumber = 0;
+    // GPU time of the last frame whose fence has signalled in milliseconds, 0 when the queue does not write timestamps
+    float gpuFrameTime = 0.0f;
     std::map<std::string, VulkanMesh> meshes;
+    std::map<uint32_t, MeshInstance> instances;
     std::map<std::string, VulkanMaterial> materials;
     std::map<std::string, Shader> shaders;
     std::unordered_map<std::string, VulkanTexture> loadedTextures;
     VulkanMaterial currentPipeline;
-    void addMesh(const std::string &name, const Mesh &mesh);
+    // returns the name the mesh is stored under, which is that of an earlier mesh with the same content if there is one
+    std::string addMesh(const std::string &name, const Mesh &mesh);
+    // returns a handle right away and reads the obj file on a worker thread, the mesh is uploaded over the next frames and
+    // its instances are drawn once it is READY. A name that is already taken returns that mesh, and a mesh that turns out
+    // to have the content of another one is dropped and its name and instances resolve to the other mesh
+    std::string loadMeshAsync(const std::string &name, const std::string &path, const MeshImportOptions &options = {});
+    // place a mesh added before, returns the id of the instance
+    uint32_t addInstance(const MeshInstance &instance);
+    void removeInstance(uint32_t id);
     ShaderLoader* getShaderLoader();
     void createShader(const Shader& info);
     void createDescriptors(const Shader &pipelineShader);
     void createGraphicsPipeline(const std::string &name, const Shader &pipelineShader);
+    // compute pipeline filling the meshlet draw buffers, shader takes the meshlets at binding 0, the draws at binding 1
+    // and MeshletCullConstants as push constants
+    void createMeshletCullPipeline(const Shader &cullShader);
     void pushConstants(const void *data, size_t size, ShaderStage stageFlags);
+    // for a range shared by several stages, stages has to list all of them
+    void pushConstants(const void *data, size_t size, const std::vector<ShaderStage> &stages);
     void bindPipeline(const std::string &name);
     // bind descriptor sets, pass dynamic offsets
     void bindDescriptorSets(const std::vector<uint32_t> &dynamicOffsets);
     void bindDescriptorSets();
     VulkanBuffer createBuffer(size_t size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage);
+    // create a GPU only buffer and fill it through a staging buffer
+    VulkanBuffer uploadToGpuBuffer(const void *data, size_t size, VkBufferUsageFlags usage);
+    // same, but fill writes the contents straight into the mapped staging memory
+    VulkanBuffer uploadToGpuBuffer(size_t size, VkBufferUsageFlags usage, const std::function<void(void *)> &fill);
+    // fill size bytes of an existing GPU only buffer at offset through a staging buffer
+    void uploadToBuffer(const VulkanBuffer &buffer, VkDeviceSize offset, size_t size, const std::function<void(void *)> &fill);
     void setUniformBuffer(const std::string &name, const void *data, size_t size);
     void immediateSubmit(const std::function<void(VkCommandBuffer)>& function);
     void addTexture(const Texture &texture, uint32_t binding);
+    // add a 1x1 placeholder for texture and load it from path on a worker thread, the materials sample the image once
+    // its copy has finished. texture holds the options to load it with
+    // a streamed texture uploads the levels up to TEXTURE_TAIL_SIZE first and the finer ones as they are requested
+    void loadTextureAsync(const Texture &texture, const std::string &path, uint32_t binding, bool streamed = false);
+    // the streamed texture name is drawn about texelsAcross texels wide this frame, others are ignored. Textures
+    // without requests fall back to their tail levels
+    void requestTextureDetail(const std::string &name, float texelsAcross);
+    void setTextureBudget(VkDeviceSize budget) { textureBudget = budget; }
+    // copy regions of RGBA8 texels into a texture added before, recorded between beginFrame and beginRenderPass.
+    // Returns false and records nothing when they do not fit into what is left of this frame's upload budget
+    bool updateTexture(const std::string &name, const std::vector<TextureRegion> &regions);
 
     VulkanBackend(const std::shared_ptr<GLFWwindow>& window, std::string_view appName, uint32_t width, uint32_t height);
     void init(uint32_t width, uint32_t height);
@@ -198,10 +439,24 @@ public:
     void createDefaultRenderPass();
     void createFramebuffers();
     void createSemaphoresAndFences();
+    // wait for the frame and begin its command buffer, compute work goes between this and beginRenderPass
     void beginFrame();
+    void beginRenderPass();
     void drawMeshes();
     void drawMesh(const VulkanMesh &mesh);
     void drawMeshIndexed(const VulkanMesh &mesh);
+    // draw from the position stream only, the bound pipeline has to be depth only
+    void drawMeshDepth(const VulkanMesh &mesh);
+    // write the meshlet draws of one instance of mesh for this frame into a free draw slot and return it, has to be
+    // recorded outside the render pass. Returns NO_DRAW_SLOT when all slots are taken
+    uint32_t cullMeshlets(VulkanMesh &mesh, const MeshletCullConstants &constants);
+    // draw what cullMeshlets left visible in slot
+    void drawMeshletsIndirect(const VulkanMesh &mesh, uint32_t slot, bool depthOnly);
+    // draw index ranges picked on the CPU
+    void drawMeshRanges(const VulkanMesh &mesh, const std::vector<IndexRange> &ranges, bool depthOnly);
+    // draw range of mesh once for every element of instances, which are copied into this frame's instance buffer. The
+    // bound pipeline has to read instanceStride bytes per instance from binding 1
+    void drawMeshInstanced(const VulkanMesh &mesh, const IndexRange &range, const void *instances, uint32_t instanceCount, uint32_t instanceStride);
     void endFrame();
     void drawFrame();
 
@@ -214,10 +469,12 @@ public:
     ~VulkanBackend();
 
     void loadMeshes();
+    // copy the streams of mesh into the geometry pools, meshes are added outside of recording a frame as a pool may
+    // be reallocated
     void uploadMesh(VulkanMesh& mesh);
 
-    VkImageCreateInfo createImageInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent);
-    VkImageViewCreateInfo createImageViewInfo(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags);
+    VkImageCreateInfo createImageInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent, uint32_t mipLevels = 1);
+    VkImageViewCreateInfo createImageViewInfo(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
     VkCommandBufferBeginInfo createCommandBufferBeginInfo(VkCommandBufferUsageFlags flags = 0);
     VkSubmitInfo createSubmitInfo(VkCommandBuffer* cmd);
     VkSamplerCreateInfo createSamplerCreateInfo(VkFilter filters, VkSamplerAddressMode samplerAddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
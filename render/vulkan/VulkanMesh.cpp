@@ -2,46 +2,146 @@
 // Created by f0xeri on 01.01.2023.
 //
 
+#include <cstring>
+#include <stdexcept>
 #include "VulkanMesh.hpp"
+#include "core/MeshCodec.hpp"
 
-VertexInputDescription VulkanVertex::getVertexDescription() {
-    VertexInputDescription description;
-
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(VulkanVertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    description.bindings.push_back(bindingDescription);
-
-    VkVertexInputAttributeDescription positionAttribute = {};
-    positionAttribute.binding = 0;
-    positionAttribute.location = 0;
-    positionAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-    positionAttribute.offset = offsetof(VulkanVertex, position);
-
-    VkVertexInputAttributeDescription normalAttribute = {};
-    normalAttribute.binding = 0;
-    normalAttribute.location = 1;
-    normalAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-    normalAttribute.offset = offsetof(VulkanVertex, normal);
-
-    VkVertexInputAttributeDescription colorAttribute = {};
-    colorAttribute.binding = 0;
-    colorAttribute.location = 2;
-    colorAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-    colorAttribute.offset = offsetof(VulkanVertex, color);
-
-    VkVertexInputAttributeDescription uvAttribute = {};
-    uvAttribute.binding = 0;
-    uvAttribute.location = 3;
-    uvAttribute.format = VK_FORMAT_R32G32_SFLOAT;
-    uvAttribute.offset = offsetof(VulkanVertex, uv);
-
-    description.attributes.push_back(positionAttribute);
-    description.attributes.push_back(normalAttribute);
-    description.attributes.push_back(colorAttribute);
-    description.attributes.push_back(uvAttribute);
-
-    return description;
+namespace {
+
+size_t alignStream(size_t offset) {
+    return (offset + 15) & ~size_t(15);
+}
+
+// FNV-1a over 64-bit words, it only has to tell meshes apart and runs over every vertex of them
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+MeshStagingLayout MeshStagingLayout::create(const Mesh &mesh) {
+    MeshStagingLayout layout;
+    size_t vertexCount = mesh.getVertexCount();
+    layout.vertexSize = vertexCount * mesh.getVertexStride();
+    layout.positionOffset = alignStream(layout.vertexOffset + layout.vertexSize);
+    layout.positionSize = mesh.positionStream ? vertexCount * mesh.getPositionStride() : 0;
+    bool shortIndices = mesh.isCooked() ? mesh.cookedStreams.indexSize == sizeof(uint16_t) : mesh.hasShortIndices();
+    layout.indexStride = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+    layout.indexOffset = alignStream(layout.positionOffset + layout.positionSize);
+    layout.indexSize = size_t(mesh.getIndexCount()) * layout.indexStride;
+    layout.meshletOffset = alignStream(layout.indexOffset + layout.indexSize);
+    layout.meshletSize = mesh.getMeshletCount() * sizeof(Meshlet);
+    layout.size = layout.meshletOffset + layout.meshletSize;
+    return layout;
+}
+
+void MeshStagingLayout::write(const Mesh &mesh, void *data) const {
+    auto bytes = static_cast<uint8_t *>(data);
+    if (mesh.isCooked() && mesh.cookedStreams.compressed) {
+        // decoded from the mapping straight into the staging memory
+        const auto &streams = mesh.cookedStreams;
+        auto vertexData = static_cast<const uint8_t *>(streams.vertexData);
+        auto indexData = static_cast<const uint8_t *>(streams.indexData);
+        if (!MeshCodec::decodeVertices(bytes + vertexOffset, streams.vertexCount, mesh.getVertexStride(), vertexData, streams.vertexDataSize) ||
+            !MeshCodec::decodeIndices(bytes + indexOffset, streams.indexCount, indexStride, streams.vertexCount, indexData, streams.indexDataSize)) {
+            throw std::runtime_error("Mesh cache streams are corrupt");
+        }
+        // the compressed cache leaves out the positions, they are copied from the start of the decoded vertices
+        if (positionSize > 0) {
+            extractPositions(mesh.vertexLayout, bytes + vertexOffset, streams.vertexCount, bytes + positionOffset);
+        }
+    }
+    else if (mesh.isCooked()) {
+        // cooked streams are already in GPU layout, the mapped bytes are copied as they are
+        const auto &streams = mesh.cookedStreams;
+        memcpy(bytes + vertexOffset, streams.vertexData, vertexSize);
+        if (positionSize > 0) {
+            memcpy(bytes + positionOffset, streams.positionData, positionSize);
+        }
+        memcpy(bytes + indexOffset, streams.indexData, indexSize);
+    }
+    else {
+        if (mesh.vertexLayout == VertexLayout::STANDARD) {
+            memcpy(bytes + vertexOffset, mesh.vertices.data(), vertexSize);
+        }
+        else {
+            encodeVertices(mesh.vertexLayout, mesh.vertices, mesh.bounds, bytes + vertexOffset);
+        }
+        if (positionSize > 0) {
+            encodePositions(mesh.vertexLayout, mesh.vertices, mesh.bounds, bytes + positionOffset);
+        }
+        if (indexStride == sizeof(uint16_t)) {
+            std::copy(mesh.indices.begin(), mesh.indices.end(), reinterpret_cast<uint16_t *>(bytes + indexOffset));
+        }
+        else {
+            memcpy(bytes + indexOffset, mesh.indices.data(), indexSize);
+        }
+    }
+    if (meshletSize > 0) {
+        memcpy(bytes + meshletOffset, mesh.getMeshlets(), meshletSize);
+    }
+}
+
+uint64_t MeshStagingLayout::hashStreams(const Mesh &mesh, const void *data) const {
+    auto bytes = static_cast<const uint8_t *>(data);
+    // the padding between the streams is left as it was, only the streams are hashed
+    uint64_t header[] = {static_cast<uint64_t>(mesh.vertexLayout), vertexSize, positionSize, indexSize, indexStride, meshletSize, mesh.getLodCount()};
+    uint64_t hash = hashBytes(14695981039346656037ull, header, sizeof(header));
+    hash = hashBytes(hash, bytes + vertexOffset, vertexSize);
+    hash = hashBytes(hash, bytes + positionOffset, positionSize);
+    hash = hashBytes(hash, bytes + indexOffset, indexSize);
+    hash = hashBytes(hash, bytes + meshletOffset, meshletSize);
+    return hashBytes(hash, mesh.getLods(), size_t(mesh.getLodCount()) * sizeof(MeshLod));
+}
+
+bool MeshStagingLayout::equalStreams(const void *data, const MeshStagingLayout &other, const void *otherData) const {
+    if (vertexSize != other.vertexSize || positionSize != other.positionSize || indexSize != other.indexSize ||
+        indexStride != other.indexStride || meshletSize != other.meshletSize) {
+        return false;
+    }
+    auto bytes = static_cast<const uint8_t *>(data);
+    auto otherBytes = static_cast<const uint8_t *>(otherData);
+    return memcmp(bytes + vertexOffset, otherBytes + other.vertexOffset, vertexSize) == 0 &&
+           memcmp(bytes + positionOffset, otherBytes + other.positionOffset, positionSize) == 0 &&
+           memcmp(bytes + indexOffset, otherBytes + other.indexOffset, indexSize) == 0 &&
+           memcmp(bytes + meshletOffset, otherBytes + other.meshletOffset, meshletSize) == 0;
+}
+
+VkPipelineVertexInputStateCreateInfo VulkanVertex::getVertexInputInfo(VertexLayout layout, bool positionOnly, InstanceLayout instanceLayout) {
+    if (instanceLayout == InstanceLayout::TERRAIN_NODE) {
+        return StandardTerrainNodeFormat::getVertexInputInfo();
+    }
+    switch (layout) {
+        case VertexLayout::HALF:
+            return positionOnly ? HalfPositionFormat::getVertexInputInfo() : HalfVertexFormat::getVertexInputInfo();
+        case VertexLayout::COMPACT:
+            return positionOnly ? CompactPositionFormat::getVertexInputInfo() : CompactVertexFormat::getVertexInputInfo();
+        default:
+            return positionOnly ? StandardPositionFormat::getVertexInputInfo() : StandardVertexFormat::getVertexInputInfo();
+    }
+}
+
+uint64_t VulkanVertex::getVertexFormatHash(VertexLayout layout, bool positionOnly, InstanceLayout instanceLayout) {
+    if (instanceLayout == InstanceLayout::TERRAIN_NODE) {
+        return StandardTerrainNodeFormat::hash;
+    }
+    switch (layout) {
+        case VertexLayout::HALF:
+            return positionOnly ? HalfPositionFormat::hash : HalfVertexFormat::hash;
+        case VertexLayout::COMPACT:
+            return positionOnly ? CompactPositionFormat::hash : CompactVertexFormat::hash;
+        default:
+            return positionOnly ? StandardPositionFormat::hash : StandardVertexFormat::hash;
+    }
 }
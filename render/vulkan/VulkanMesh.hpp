@@ -6,27 +6,160 @@
 #define VULKAN_EXPERIMENTS_VULKANMESH_HPP
 
 #include <vulkan/vulkan.h>
+#include <cstddef>
+#include <string>
 #include <vector>
 #include "vk_mem_alloc.h"
 #include "VulkanBuffer.hpp"
 #include "glm/glm.hpp"
 #include "core/Mesh.hpp"
+#include "core/RangeAllocator.hpp"
+#include "core/TerrainQuadtree.hpp"
 #include "VulkanShader.hpp"
+#include "VulkanVertexFormat.hpp"
 
-struct VertexInputDescription {
-    std::vector<VkVertexInputBindingDescription> bindings;
-    std::vector<VkVertexInputAttributeDescription> attributes;
+using StandardVertexFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT>,
+                                                VertexAttribute<1, VK_FORMAT_R32G32B32_SFLOAT>,
+                                                VertexAttribute<2, VK_FORMAT_R32G32B32_SFLOAT>,
+                                                VertexAttribute<3, VK_FORMAT_R32G32_SFLOAT>>;
+// quantized layouts keep the standard locations and drop the color, the shader reads the normal as an octahedral vec2
+using HalfVertexFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R16G16B16A16_SFLOAT>,
+                                            VertexAttribute<1, VK_FORMAT_R16G16_SNORM>,
+                                            VertexAttribute<3, VK_FORMAT_R16G16_SFLOAT>>;
+// three component 16-bit formats are not guaranteed for vertex buffers, the position is fetched as four components
+// and its last one overlaps the 8-bit normal
+using CompactVertexFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R16G16B16A16_UNORM, 6>,
+                                               VertexAttribute<1, VK_FORMAT_R8G8_SNORM>,
+                                               VertexAttribute<3, VK_FORMAT_R16G16_UNORM>>;
 
-    VkPipelineVertexInputStateCreateFlags flags = 0;
-};
+// position-only streams for depth passes, the quantized ones are padded to four components
+using StandardPositionFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT>>;
+using HalfPositionFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R16G16B16A16_SFLOAT>>;
+using CompactPositionFormat = VulkanVertexFormat<VertexAttribute<0, VK_FORMAT_R16G16B16A16_UNORM>>;
+
+// chunked lod terrain nodes, see TerrainNode
+using TerrainNodeFormat = VulkanVertexFormat<VertexAttribute<4, VK_FORMAT_R32G32B32A32_SFLOAT>,
+                                             VertexAttribute<5, VK_FORMAT_R32G32B32A32_SFLOAT>>;
+using StandardTerrainNodeFormat = VulkanInstancedVertexFormat<StandardVertexFormat, TerrainNodeFormat>;
+
+static_assert(StandardVertexFormat::stride == sizeof(Vertex) && StandardVertexFormat::attributes[3].offset == offsetof(Vertex, uv));
+static_assert(HalfVertexFormat::stride == sizeof(HalfVertex) && HalfVertexFormat::attributes[2].offset == offsetof(HalfVertex, uv));
+static_assert(CompactVertexFormat::stride == sizeof(CompactVertex) && CompactVertexFormat::attributes[1].offset == offsetof(CompactVertex, normal));
+static_assert(StandardPositionFormat::stride == sizeof(glm::vec3) && HalfPositionFormat::stride == sizeof(QuantizedPosition) &&
+              CompactPositionFormat::stride == sizeof(QuantizedPosition));
+static_assert(TerrainNodeFormat::stride == sizeof(TerrainNode));
 
 struct VulkanVertex : public Vertex {
-    static VertexInputDescription getVertexDescription();
+    // positionOnly describes the de-interleaved position stream instead of the full vertices. Instance layouts are only
+    // combined with the full STANDARD vertices
+    static VkPipelineVertexInputStateCreateInfo getVertexInputInfo(VertexLayout layout = VertexLayout::STANDARD, bool positionOnly = false,
+                                                                   InstanceLayout instanceLayout = InstanceLayout::NONE);
+    static uint64_t getVertexFormatHash(VertexLayout layout, bool positionOnly = false, InstanceLayout instanceLayout = InstanceLayout::NONE);
+};
+
+// Megabuffer shared by the meshes of one vertex layout or index type, a mesh is a range of its elements
+struct VulkanGeometryPool {
+    VulkanBuffer buffer;
+    // vertex pools only, the positions of the same vertices at the same offsets so that one vertexOffset serves the
+    // color and the depth pass. Created with the first mesh that has a position stream
+    VulkanBuffer positionBuffer;
+    RangeAllocator allocator;
+    uint32_t stride = 0;
+    uint32_t positionStride = 0;
+};
+
+// Contents of a geometry pool buffer carried over into the larger one that replaced it, recorded with the next frame
+struct GeometryPoolCopy {
+    VulkanBuffer source;
+    VkBuffer target = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+};
+
+// Where the streams of a mesh go in a staging buffer, each one starts 16-byte aligned
+struct MeshStagingLayout {
+    size_t vertexOffset = 0;
+    size_t vertexSize = 0;
+    size_t positionOffset = 0;
+    size_t positionSize = 0;
+    size_t indexOffset = 0;
+    size_t indexSize = 0;
+    uint32_t indexStride = sizeof(uint32_t);
+    size_t meshletOffset = 0;
+    size_t meshletSize = 0;
+    size_t size = 0;
+
+    static MeshStagingLayout create(const Mesh &mesh);
+    // write the streams of mesh in their GPU layout to data, which holds size bytes
+    void write(const Mesh &mesh, void *data) const;
+    // hash of the streams written to data and of the lods of mesh. It is taken from the GPU layout, so a mesh hashes
+    // the same whether it was imported or read from its cache
+    uint64_t hashStreams(const Mesh &mesh, const void *data) const;
+    // the streams written to data and those of other written to otherData are the same bytes
+    bool equalStreams(const void *data, const MeshStagingLayout &other, const void *otherData) const;
+};
+
+enum class MeshBufferTarget {
+    VERTICES,
+    POSITIONS,
+    INDICES,
+    MESHLETS,
+};
+
+// Copy from a staging buffer into a buffer of the mesh, resolved when recorded as the geometry pools may be reallocated
+struct MeshBufferCopy {
+    MeshBufferTarget target;
+    VkDeviceSize srcOffset = 0;
+    VkDeviceSize dstOffset = 0;
+    VkDeviceSize size = 0;
+};
+
+enum class MeshState {
+    // holds its data, uploaded with the next loadMeshes
+    QUEUED,
+    // being read on a worker thread
+    LOADING,
+    // copies are recorded into the frames, drawn once the fence of the last of them has signalled
+    UPLOADING,
+    READY,
+    FAILED,
 };
 
 struct VulkanMesh : public Mesh {
-    VulkanBuffer vertexBuffer;
-    VulkanBuffer indexBuffer;
+    MeshState state = MeshState::QUEUED;
+    // ranges of the geometry pools in vertices and indices, INVALID_OFFSET until uploaded
+    uint32_t vertexOffset = RangeAllocator::INVALID_OFFSET;
+    uint32_t firstIndex = RangeAllocator::INVALID_OFFSET;
+    // meshlets as a storage buffer and one indexed indirect draw per meshlet, written by the culling shader
+    VulkanBuffer meshletBuffer;
+    VulkanBuffer meshletDrawBuffer;
+    VkDescriptorSet meshletCullSet = VK_NULL_HANDLE;
+    uint32_t meshletCount = 0;
+    // the draw buffer holds meshletCount draws per slot, every instance culled on the GPU in a frame takes one
+    uint32_t meshletDrawSlots = 0;
+    uint32_t meshletDrawSlotsUsed = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint32_t indexCount = 0;
+    // meshes added with the same content resolve to the first one
+    uint64_t contentHash = 0;
+    // instances drawing the mesh, its buffers are released with the last one
+    uint32_t referenceCount = 0;
+};
+
+enum MeshInstanceFlags : uint32_t {
+    MESH_INSTANCE_HIDDEN = 1u << 0,
+    // always drawn at full resolution
+    MESH_INSTANCE_NO_LOD = 1u << 1,
+    // only drawn in the color pass
+    MESH_INSTANCE_NO_DEPTH_PREPASS = 1u << 2,
+};
+
+// One placement of a mesh in the scene, any number of them share the mesh's buffers
+struct MeshInstance {
+    std::string mesh;
+    // pipeline of the color pass, empty picks the default one for the mesh's vertex layout
+    std::string material;
+    glm::mat4 model = glm::mat4(1.0f);
+    uint32_t flags = 0;
 };
 
 struct VulkanMaterial {
@@ -34,6 +167,8 @@ struct VulkanMaterial {
     VkPipeline pipeline = {};
     VkPipelineLayout pipelineLayout = {};
     VkDescriptorSet textureSet = VK_NULL_HANDLE;
+    // vertex input the pipeline was built for, bindGeometry checks the meshes drawn with it against it
+    uint64_t vertexFormatHash = 0;
 };
 
 struct VulkanRenderObject : public RenderObject {
@@ -42,6 +42,7 @@ VkPipeline VulkanPipelineBuilder::buildPipeline(VkDevice device, VkRenderPass pa
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pTessellationState = tessellation.patchControlPoints > 0 ? &tessellation : nullptr;
 
     VkPipeline newPipeline;
     if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
@@ -154,3 +155,11 @@ VkPipelineDepthStencilStateCreateInfo VulkanPipelineBuilder::createDepthStencilI
     depthStencil.stencilTestEnable = VK_FALSE;
     return depthStencil;
 }
+
+VkPipelineTessellationStateCreateInfo VulkanPipelineBuilder::createTessellationInfo(uint32_t patchControlPoints) {
+    VkPipelineTessellationStateCreateInfo tessellation = {};
+    tessellation.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
+    tessellation.pNext = nullptr;
+    tessellation.patchControlPoints = patchControlPoints;
+    return tessellation;
+}
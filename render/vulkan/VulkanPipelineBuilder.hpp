@@ -20,6 +20,8 @@ public:
     VkPipelineColorBlendAttachmentState colorBlendAttachment;
     VkPipelineMultisampleStateCreateInfo multisampling;
     VkPipelineDepthStencilStateCreateInfo depthStencil;
+    // only used when patchControlPoints is not 0
+    VkPipelineTessellationStateCreateInfo tessellation = {};
     VkPipelineLayout pipelineLayout;
 
     VkPipeline buildPipeline(VkDevice device, VkRenderPass pass);
@@ -33,6 +35,7 @@ public:
     static VkPipelineColorBlendAttachmentState createColorBlendAttachmentState();
     static VkPipelineLayoutCreateInfo createPipelineLayoutInfo();
     static VkPipelineDepthStencilStateCreateInfo createDepthStencilInfo(bool bDepthTest, bool bDepthWrite, VkCompareOp compareOp);
+    static VkPipelineTessellationStateCreateInfo createTessellationInfo(uint32_t patchControlPoints);
     ~VulkanPipelineBuilder();
 };
 
@@ -12,6 +12,10 @@ VulkanShader::VulkanShader(VkDevice device, const Shader &info) {
     this->stagesInfo = info.stagesInfo;
     this->descriptorBinding = info.descriptorBinding;
     this->constants = info.constants;
+    this->vertexLayout = info.vertexLayout;
+    this->instanceLayout = info.instanceLayout;
+    this->depthOnly = info.depthOnly;
+    this->patchControlPoints = info.patchControlPoints;
     name = info.name;
     stages.reserve(info.stagesInfo.size());
     for (const auto& stageInfo : info.stagesInfo) {
@@ -0,0 +1,139 @@
+//
+// Created by f0xeri on 18.10.2026.
+//
+
+#ifndef VULKAN_EXPERIMENTS_VULKANVERTEXFORMAT_HPP
+#define VULKAN_EXPERIMENTS_VULKANVERTEXFORMAT_HPP
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+
+constexpr uint32_t getVertexFormatSize(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SNORM:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SNORM:
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16_SNORM:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// One attribute of a vertex format, the next attribute starts Size bytes after it. Size can be smaller than the
+// format to let the fetch overlap the following attribute, e.g. a 16-bit xyz position read as four components
+template<uint32_t Location, VkFormat Format, uint32_t Size = getVertexFormatSize(Format)>
+struct VertexAttribute {
+    static_assert(getVertexFormatSize(Format) != 0, "Unknown vertex attribute format");
+
+    static constexpr uint32_t location = Location;
+    static constexpr VkFormat format = Format;
+    static constexpr uint32_t size = Size;
+};
+
+// Vertex input state of a single interleaved binding, built at compile time from the attribute list
+template<typename... Attributes>
+struct VulkanVertexFormat {
+    static constexpr uint32_t stride = (Attributes::size + ...);
+
+    static constexpr std::array<VkVertexInputBindingDescription, 1> bindings = {{
+        {0, stride, VK_VERTEX_INPUT_RATE_VERTEX}
+    }};
+
+    static constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> attributes = [] {
+        std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> result = {};
+        uint32_t offset = 0;
+        uint32_t i = 0;
+        ((result[i++] = {Attributes::location, 0, Attributes::format, offset}, offset += Attributes::size), ...);
+        return result;
+    }();
+
+    // FNV-1a over the descriptions, equal hashes mean pipelines can share vertex buffers
+    static constexpr uint64_t hash = [] {
+        uint64_t result = 14695981039346656037ull;
+        auto combine = [&result](uint64_t value) {
+            for (int i = 0; i < 8; i++) {
+                result = (result ^ ((value >> (i * 8)) & 0xFF)) * 1099511628211ull;
+            }
+        };
+        combine(stride);
+        for (const auto &attribute : attributes) {
+            combine(attribute.location);
+            combine(static_cast<uint64_t>(attribute.format));
+            combine(attribute.offset);
+        }
+        return result;
+    }();
+
+    // points into the static arrays, nothing is allocated per pipeline
+    static VkPipelineVertexInputStateCreateInfo getVertexInputInfo() {
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.pNext = nullptr;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+        vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+        return vertexInputInfo;
+    }
+};
+
+// Vertex format at binding 0 followed by the attributes of InstanceFormat, read per instance from binding 1
+template<typename VertexFormat, typename InstanceFormat>
+struct VulkanInstancedVertexFormat {
+    static constexpr std::array<VkVertexInputBindingDescription, 2> bindings = {{
+        {0, VertexFormat::stride, VK_VERTEX_INPUT_RATE_VERTEX},
+        {1, InstanceFormat::stride, VK_VERTEX_INPUT_RATE_INSTANCE}
+    }};
+
+    static constexpr std::array<VkVertexInputAttributeDescription, VertexFormat::attributes.size() + InstanceFormat::attributes.size()> attributes = [] {
+        std::array<VkVertexInputAttributeDescription, VertexFormat::attributes.size() + InstanceFormat::attributes.size()> result = {};
+        uint32_t i = 0;
+        for (const auto &attribute : VertexFormat::attributes) {
+            result[i++] = attribute;
+        }
+        for (auto attribute : InstanceFormat::attributes) {
+            attribute.binding = 1;
+            result[i++] = attribute;
+        }
+        return result;
+    }();
+
+    static constexpr uint64_t hash = [] {
+        uint64_t result = VertexFormat::hash;
+        for (int i = 0; i < 8; i++) {
+            result = (result ^ ((InstanceFormat::hash >> (i * 8)) & 0xFF)) * 1099511628211ull;
+        }
+        return result;
+    }();
+
+    static VkPipelineVertexInputStateCreateInfo getVertexInputInfo() {
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.pNext = nullptr;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+        vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+        return vertexInputInfo;
+    }
+};
+
+
+#endif //VULKAN_EXPERIMENTS_VULKANVERTEXFORMAT_HPP